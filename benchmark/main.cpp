@@ -0,0 +1,342 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <common/mazerouter.hpp>
+#include <common/steinertree.hpp>
+#include <patterns/structural/bridge.hpp>
+
+using namespace common;
+using namespace structural;
+
+//Benchmarks of the performance requests. Every benchmark takes a scale factor (1 by default) that
+//multiplies its problem size and prints one line per measurement.
+
+namespace
+{
+  template <class Function>
+  double seconds(Function function)
+  {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  //levelized random timing graph: every node of a level has fanins fanins in the previous level
+  void randomTimingGraph(unsigned numLevels, unsigned width, unsigned fanins, std::vector<TimingPoint> & timingPoints, std::vector<TimingArc> & arcs)
+  {
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> delay(0.1, 3.0);
+    timingPoints.clear();
+    arcs.clear();
+    timingPoints.reserve(std::size_t(numLevels) * width);
+    arcs.reserve(std::size_t(numLevels) * width * fanins);
+    for(unsigned node = 0; node < numLevels * width; ++node)
+    {
+      timingPoints.push_back({node, node, 0.0});
+      for(unsigned fanin = 0; node >= width && fanin < fanins; ++fanin)
+      {
+        arcs.push_back({node - width - node % width + unsigned(generator() % width), node, delay(generator)});
+      }
+    }
+  }
+
+  //user-001: full late/early STA with 1 to 64 threads
+  void threadScaling(std::size_t scale)
+  {
+    std::vector<TimingPoint> timingPoints;
+    std::vector<TimingArc> arcs;
+    randomTimingGraph(64, 16384 * scale, 3, timingPoints, arcs);
+    LateEarlyTimingAnalysisInterface sta( std::make_unique<EffectiveCapElmoreDelayTimingAnalysisImplementation>(timingPoints, arcs, 100.0) );
+
+    double serial = 0.0;
+    for(int numThreads = 1; numThreads <= 64; numThreads *= 2)
+    {
+#ifdef _OPENMP
+      omp_set_num_threads(numThreads);
+#else
+      if(numThreads > 1)
+        break;
+#endif
+      double time = seconds([&] { sta.run(); });
+      serial = numThreads == 1 ? time : serial;
+      std::cout << "threads " << numThreads << ": " << time << " s, speedup " << serial / time << std::endl;
+    }
+  }
+
+  //user-002: CSR construction and levelized sort of a 10M node timing graph, expected to take a few seconds
+  void timingGraphConstruction(std::size_t scale)
+  {
+    std::vector<TimingPoint> timingPoints;
+    std::vector<TimingArc> arcs;
+    randomTimingGraph(100, 100000 * scale, 2, timingPoints, arcs);
+
+    TimingGraph graph;
+    double construction = seconds([&] { graph = TimingGraph(timingPoints.size(), arcs); });
+    TopologicalOrder order;
+    double sort = seconds([&] { order = graph.topologicalSort(); });
+    std::cout << timingPoints.size() << " nodes, " << arcs.size() << " arcs: construction " << construction
+              << " s, topological sort " << sort << " s (" << order.numLevels() << " levels)" << std::endl;
+  }
+
+  //user-006: the real late STA of TimingAnalysisImplementation, whose propagation loops call the kernels
+  //directly, against the same kernels called through a virtual delay hook per timing point, as the
+  //per timing point delay model hooks did before the delay model layer was removed
+  class VirtualHookTimingAnalysis : public LumpedCapElmoreDelayTimingAnalysisImplementation
+  {
+    std::vector<TimingPoint> m_sortedTimingPoints;
+
+    public:
+      VirtualHookTimingAnalysis(const std::vector<TimingPoint> & timingPoints, const std::vector<TimingArc> & timingArcs, double clockPeriod) :
+      LumpedCapElmoreDelayTimingAnalysisImplementation(timingPoints, timingArcs, clockPeriod)
+      {
+        for(auto node : graph().topologicalSort().nodes)
+        {
+          m_sortedTimingPoints.push_back(timingPoints[node]);
+        }
+      }
+
+      virtual void propagateLateArrivalHook(const TimingPoint & timingPoint) { propagateLateArrival(timingPoint); }
+      virtual void propagateLateRequiredHook(const TimingPoint & timingPoint) { propagateLateRequired(timingPoint); }
+
+      void runLateScenarioWithHooks()
+      {
+        for(auto & tp : m_sortedTimingPoints)
+        {
+          propagateLateArrivalHook(tp);
+        }
+        for(auto tp = m_sortedTimingPoints.rbegin(); tp != m_sortedTimingPoints.rend(); ++tp)
+        {
+          propagateLateRequiredHook(*tp);
+        }
+      }
+  };
+
+  void virtualDispatch(std::size_t scale)
+  {
+    std::vector<TimingPoint> timingPoints;
+    std::vector<TimingArc> arcs;
+    randomTimingGraph(32, 65536 * scale, 3, timingPoints, arcs);
+#ifdef _OPENMP
+    //the hooked variant is serial
+    const int maxThreads = omp_get_max_threads();
+    omp_set_num_threads(1);
+#endif
+
+    LumpedCapElmoreDelayTimingAnalysisImplementation direct(timingPoints, arcs, 100.0);
+    std::unique_ptr<VirtualHookTimingAnalysis> hooked(new VirtualHookTimingAnalysis(timingPoints, arcs, 100.0));
+    //warm up, both analyses start with their timing values in cache
+    direct.runLateScenario();
+    hooked->runLateScenarioWithHooks();
+    const int repetitions = 5;
+    double directTime = seconds([&]
+    {
+      for(int repetition = 0; repetition < repetitions; ++repetition)
+        direct.runLateScenario();
+    });
+    double hookedTime = seconds([&]
+    {
+      for(int repetition = 0; repetition < repetitions; ++repetition)
+        hooked->runLateScenarioWithHooks();
+    });
+#ifdef _OPENMP
+    omp_set_num_threads(maxThreads);
+#endif
+
+    bool match = true;
+    for(auto & tp : timingPoints)
+    {
+      match = match && direct.lateSlack(tp) == hooked->lateSlack(tp);
+    }
+    const double nodes = double(timingPoints.size()) * repetitions;
+    std::cout << "virtual delay hook per timing point: " << 1e9 * hookedTime / nodes << " ns/timing point" << std::endl;
+    std::cout << "runLateScenario(): " << 1e9 * directTime / nodes << " ns/timing point, speedup " << hookedTime / directTime
+              << (match ? "" : " (MISMATCH)") << std::endl;
+  }
+
+  //user-007: RC tree delay evaluation throughput of every load and wire delay model
+  template <LoadModel Load, WireDelayModel Wire>
+  void rcTreeThroughput(const char * name, const RCTreeArena & arena)
+  {
+    std::vector<double> delays;
+    computeNetDelays<Load, Wire>(arena, delays); //warm up
+    const int repetitions = 5;
+    double time = seconds([&]
+    {
+      for(int repetition = 0; repetition < repetitions; ++repetition)
+        computeNetDelays<Load, Wire>(arena, delays);
+    });
+    std::cout << name << ": " << arena.numTrees() * repetitions / time << " trees/s" << std::endl;
+  }
+
+  void rcTreeDelays(std::size_t scale)
+  {
+    const std::size_t numTrees = 200000 * scale;
+    std::mt19937 generator(11);
+    std::uniform_int_distribution<unsigned> treeSize(2, 16);
+    std::uniform_real_distribution<double> resistance(10.0, 100.0), capacitance(0.5, 5.0);
+    RCTreeArena arena;
+    arena.reserve(numTrees, numTrees * 9);
+    for(std::size_t tree = 0; tree < numTrees; ++tree)
+    {
+      arena.addTree(resistance(generator), capacitance(generator));
+      const unsigned size = treeSize(generator);
+      for(unsigned node = 1; node < size; ++node)
+      {
+        arena.addNode(std::uniform_int_distribution<unsigned>(0, node - 1)(generator), resistance(generator), capacitance(generator));
+      }
+    }
+    std::cout << arena.numTrees() << " trees, " << arena.numNodes() << " nodes" << std::endl;
+
+    rcTreeThroughput<LoadModel::LUMPED_CAPACITANCE, WireDelayModel::ELMORE>("lumped capacitance + Elmore", arena);
+    rcTreeThroughput<LoadModel::EFFECTIVE_CAPACITANCE, WireDelayModel::ELMORE>("effective capacitance + Elmore", arena);
+    rcTreeThroughput<LoadModel::LUMPED_CAPACITANCE, WireDelayModel::D2M>("lumped capacitance + D2M", arena);
+    rcTreeThroughput<LoadModel::EFFECTIVE_CAPACITANCE, WireDelayModel::D2M>("effective capacitance + D2M", arena);
+  }
+
+  //user-009: new analysis session restored from a timing snapshot vs rebuilding, sorting and timing the graph
+  void snapshotColdStart(std::size_t scale)
+  {
+    std::vector<TimingPoint> timingPoints;
+    std::vector<TimingArc> arcs;
+    randomTimingGraph(64, 65536 * scale, 2, timingPoints, arcs);
+    const std::string file = "timing_snapshot_benchmark.bin";
+
+    std::unique_ptr<TimingAnalysisImplementation> rebuilt;
+    double rebuild = seconds([&]
+    {
+      rebuilt = std::make_unique<LumpedCapElmoreDelayTimingAnalysisImplementation>(timingPoints, arcs, 100.0);
+      rebuilt->runLateEarlyScenario();
+    });
+    double write = seconds([&] { rebuilt->writeSnapshot(file); });
+
+    std::unique_ptr<TimingAnalysisImplementation> restored;
+    double coldStart = seconds([&]
+    {
+      TimingSnapshot snapshot(file);
+      restored = std::make_unique<LumpedCapElmoreDelayTimingAnalysisImplementation>(snapshot);
+    });
+    std::remove(file.c_str());
+
+    std::cout << timingPoints.size() << " timing points: rebuild and full STA " << rebuild << " s, snapshot write " << write
+              << " s, cold start from the snapshot " << coldStart << " s, speedup " << rebuild / coldStart
+              << (restored->endPointLateSlacks() == rebuilt->endPointLateSlacks() ? "" : " (MISMATCH)") << std::endl;
+  }
+
+  //nets of 2 to maxPins pins with a bounding box of at most span x span GCells inside a size x size die
+  std::vector<Net> randomNets(std::size_t numNets, unsigned size, unsigned span, unsigned maxPins)
+  {
+    std::mt19937 generator(13);
+    std::vector<Net> nets(numNets);
+    for(std::size_t i = 0; i < numNets; ++i)
+    {
+      Net & net = nets[i];
+      const unsigned lowerX = generator() % (size - span), lowerY = generator() % (size - span);
+      net.name = "n" + std::to_string(i);
+      net.num_pins = 2 + generator() % (maxPins - 1);
+      for(unsigned pin = 0; pin < net.num_pins; ++pin)
+      {
+        net.pins.push_back(Location{lowerX + unsigned(generator() % span), lowerY + unsigned(generator() % span)});
+      }
+      net.bbox = BoundingBox{Location{lowerX, lowerY}, Location{lowerX + span - 1, lowerY + span - 1}};
+    }
+    return nets;
+  }
+
+  //user-012: A* maze routing throughput and search effort on an empty grid and after negotiated congestion history
+  void mazeRouting(std::size_t scale)
+  {
+    CongestionMap map(GCellGrid(512, 512, 4), 8, 16);
+    std::vector<Net> nets = randomNets(20000 * scale, 512, 32, 5);
+    MazeRouter router(map);
+    MazeRouteScratch scratch;
+
+    for(bool history : {false, true})
+    {
+      if(history)
+      {
+        //heavy history costs on every other edge, past the bucket queue
+        for(std::uint32_t edge = 0; edge < map.numEdges(); edge += 2)
+        {
+          map.addHistoryCost(edge, 100000);
+        }
+      }
+      scratch.expandedNodes = 0;
+      std::size_t routed = 0;
+      double time = seconds([&]
+      {
+        for(auto & net : nets)
+        {
+          routed += router.route(net, scratch);
+        }
+      });
+      std::cout << (history ? "with history costs: " : "empty grid: ") << nets.size() / time << " nets/s, "
+                << double(scratch.expandedNodes) / nets.size() << " expanded nodes/net, " << routed << " routed" << std::endl;
+    }
+  }
+
+  //user-017: Steiner trees/s of the lookup table (small nets) and of the heuristic (large nets)
+  void steinerTrees(std::size_t scale)
+  {
+    SteinerLookupTable::instance(); //not timed, generated once per process
+    for(unsigned maxPins : {SteinerLookupTable::MaxDegree, 9u, 32u})
+    {
+      std::vector<Net> nets = randomNets(100000 * scale, 4096, 64, maxPins);
+      std::vector<std::vector<Location>> pins;
+      for(auto & net : nets)
+      {
+        pins.push_back(net.pins);
+      }
+      std::vector<SteinerTree> trees;
+      double time = seconds([&] { trees = buildSteinerTrees(pins); });
+      std::uint64_t wirelength = 0;
+      for(auto & tree : trees)
+      {
+        wirelength += tree.wirelength();
+      }
+      std::cout << "2 to " << maxPins << " pins: " << pins.size() / time << " trees/s, average wirelength "
+                << double(wirelength) / trees.size() << std::endl;
+    }
+  }
+
+  struct Benchmark
+  {
+    std::string name;
+    std::function<void(std::size_t)> run;
+  };
+}
+
+int main(int argc, char ** argv)
+{
+  const std::vector<Benchmark> benchmarks{
+    {"sta-thread-scaling", threadScaling},
+    {"timing-graph-construction", timingGraphConstruction},
+    {"virtual-vs-inlined-propagation", virtualDispatch},
+    {"rc-tree-delays", rcTreeDelays},
+    {"snapshot-cold-start", snapshotColdStart},
+    {"maze-routing", mazeRouting},
+    {"steiner-trees", steinerTrees},
+  };
+
+  const std::string filter = argc > 1 ? argv[1] : "";
+  const std::size_t scale = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1;
+  for(auto & benchmark : benchmarks)
+  {
+    if(filter.empty() || filter == benchmark.name)
+    {
+      std::cout << "=== " << benchmark.name << std::endl;
+      benchmark.run(scale);
+    }
+  }
+  return 0;
+}
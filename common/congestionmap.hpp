@@ -0,0 +1,137 @@
+#ifndef COMMON_CONGESTION_MAP_HPP
+#define COMMON_CONGESTION_MAP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+#include "gcellgrid.hpp"
+
+namespace common
+{
+  static_assert(ATOMIC_INT_LOCK_FREE == 2, "the congestion map relies on lock-free 32 bits atomics");
+
+  //Routing resources of a GCellGrid shared by all the routing threads: capacity, usage and history cost
+  //of every edge. Usages and history costs are relaxed atomics, so concurrent routes are committed and
+  //ripped up without a lock and readers never block; a reader may see a value that is being updated,
+  //which only makes a cost estimate slightly stale.
+  class CongestionMap : public boost::noncopyable
+  {
+    GCellGrid m_grid;
+    std::vector<std::uint32_t> m_capacities;
+    std::unique_ptr<std::atomic<std::uint32_t>[]> m_usages;
+    std::unique_ptr<std::atomic<std::uint32_t>[]> m_historyCosts;
+
+    public:
+      CongestionMap(const GCellGrid & grid, std::uint32_t wireCapacity, std::uint32_t viaCapacity) :
+        m_grid(grid),
+        m_capacities(grid.numEdges(), 0),
+        m_usages(new std::atomic<std::uint32_t>[grid.numEdges()]),
+        m_historyCosts(new std::atomic<std::uint32_t>[grid.numEdges()])
+      {
+        for(std::uint32_t edge = 0; edge < numEdges(); ++edge)
+        {
+          if(m_grid.edgeExists(edge))
+            m_capacities[edge] = m_grid.edgeDirection(edge) == GCellDirection::UP ? viaCapacity : wireCapacity;
+          m_usages[edge].store(0, std::memory_order_relaxed);
+          m_historyCosts[edge].store(0, std::memory_order_relaxed);
+        }
+      }
+
+      const GCellGrid & grid() const { return m_grid; }
+      std::size_t numEdges() const { return m_grid.numEdges(); }
+
+      std::uint32_t capacity(std::uint32_t edge) const { return m_capacities[edge]; }
+      //capacities are set up before routing starts, they are not synchronized
+      void setCapacity(std::uint32_t edge, std::uint32_t capacity) { m_capacities[edge] = capacity; }
+
+      std::uint32_t usage(std::uint32_t edge) const { return m_usages[edge].load(std::memory_order_relaxed); }
+      void addUsage(std::uint32_t edge) { m_usages[edge].fetch_add(1, std::memory_order_relaxed); }
+      void removeUsage(std::uint32_t edge) { m_usages[edge].fetch_sub(1, std::memory_order_relaxed); }
+
+      //commits (or rips up) all the edges of a route
+      void addRoute(const std::vector<std::uint32_t> & route)
+      {
+        for(auto edge : route)
+        {
+          addUsage(edge);
+        }
+      }
+      void removeRoute(const std::vector<std::uint32_t> & route)
+      {
+        for(auto edge : route)
+        {
+          removeUsage(edge);
+        }
+      }
+
+      bool available(std::uint32_t edge) const { return usage(edge) < capacity(edge); }
+
+      std::uint32_t overflow(std::uint32_t edge) const
+      {
+        std::uint32_t used = usage(edge);
+        return used > capacity(edge) ? used - capacity(edge) : 0;
+      }
+
+      std::uint64_t totalOverflow() const
+      {
+        const std::ptrdiff_t size = numEdges();
+        std::uint64_t total = 0;
+#ifdef _OPENMP
+        #pragma omp parallel for reduction(+:total)
+#endif
+        for(std::ptrdiff_t edge = 0; edge < size; ++edge)
+        {
+          total += overflow(edge);
+        }
+        return total;
+      }
+
+      std::vector<std::uint32_t> overflowedEdges() const
+      {
+        std::vector<std::uint32_t> edges;
+        for(std::uint32_t edge = 0; edge < numEdges(); ++edge)
+        {
+          if(overflow(edge) > 0)
+            edges.push_back(edge);
+        }
+        return edges;
+      }
+
+      //history cost accumulated by an edge over the negotiated congestion iterations
+      std::uint32_t historyCost(std::uint32_t edge) const { return m_historyCosts[edge].load(std::memory_order_relaxed); }
+
+      //the history cost saturates at the largest 32 bits value instead of wrapping around
+      void addHistoryCost(std::uint32_t edge, std::uint32_t cost)
+      {
+        const std::uint32_t maximum = std::numeric_limits<std::uint32_t>::max();
+        std::uint32_t current = m_historyCosts[edge].load(std::memory_order_relaxed);
+        while(!m_historyCosts[edge].compare_exchange_weak(current, current > maximum - cost ? maximum : current + cost, std::memory_order_relaxed))
+        {
+        }
+      }
+
+      //adds increment times the overflow of every overflowed edge to its history cost
+      void updateHistoryCosts(std::uint32_t increment)
+      {
+        const std::ptrdiff_t size = numEdges();
+#ifdef _OPENMP
+        #pragma omp parallel for
+#endif
+        for(std::ptrdiff_t edge = 0; edge < size; ++edge)
+        {
+          if(std::uint32_t over = overflow(edge))
+            addHistoryCost(edge, std::uint32_t(std::min<std::uint64_t>(std::uint64_t(increment) * over, std::numeric_limits<std::uint32_t>::max())));
+        }
+      }
+  };
+
+} //end of namespace common
+
+#endif //COMMON_CONGESTION_MAP_HPP
@@ -0,0 +1,86 @@
+#ifndef COMMON_GCELL_GRID_HPP
+#define COMMON_GCELL_GRID_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+namespace common
+{
+  //directions of the edges leaving a GCell towards its upper neighbours
+  enum class GCellDirection {EAST, NORTH, UP};
+
+  //Global routing grid of width x height GCells on numLayers layers. Even layers route horizontally,
+  //odd layers vertically and vias connect the same GCell of adjacent layers. Each GCell owns the
+  //edges to its east, north and upper neighbours, so edge = 3 * node + direction.
+  //The grid only describes the geometry, the routing resources are kept by the CongestionMap.
+  class GCellGrid
+  {
+    unsigned m_width;
+    unsigned m_height;
+    unsigned m_numLayers;
+
+    public:
+      static constexpr unsigned NumDirections = 3;
+
+      GCellGrid(unsigned width, unsigned height, unsigned numLayers) :
+        m_width(width), m_height(height), m_numLayers(numLayers)
+      {
+        if(width == 0 || height == 0 || numLayers == 0)
+          throw std::runtime_error("GCell grid must have at least one GCell");
+        //nodes and edges are identified by 32 bits ids
+        if(std::uint64_t(width) * height > std::numeric_limits<std::uint32_t>::max() / NumDirections / numLayers)
+          throw std::overflow_error("Too many GCell grid edges for the id type");
+      }
+
+      unsigned width() const { return m_width; }
+      unsigned height() const { return m_height; }
+      unsigned numLayers() const { return m_numLayers; }
+      std::size_t numNodes() const { return std::size_t(m_width) * m_height * m_numLayers; }
+      std::size_t numEdges() const { return numNodes() * NumDirections; }
+
+      std::uint32_t node(unsigned x, unsigned y, unsigned layer) const { return (layer * m_height + y) * m_width + x; }
+      unsigned x(std::uint32_t node) const { return node % m_width; }
+      unsigned y(std::uint32_t node) const { return node / m_width % m_height; }
+      unsigned layer(std::uint32_t node) const { return node / m_width / m_height; }
+
+      bool horizontal(unsigned layer) const { return layer % 2 == 0; }
+
+      std::uint32_t edge(std::uint32_t node, GCellDirection direction) const { return node * NumDirections + unsigned(direction); }
+      std::uint32_t edgeSource(std::uint32_t edge) const { return edge / NumDirections; }
+      GCellDirection edgeDirection(std::uint32_t edge) const { return GCellDirection(edge % NumDirections); }
+
+      //distance between the ids of two neighbour GCells in direction
+      std::uint32_t stride(GCellDirection direction) const
+      {
+        switch(direction)
+        {
+          case GCellDirection::EAST: return 1;
+          case GCellDirection::NORTH: return m_width;
+          case GCellDirection::UP: return m_width * m_height;
+        }
+        return 0;
+      }
+
+      //upper neighbour of node in direction, or node itself when the edge does not exist
+      //(grid boundary or non-preferred direction of the layer)
+      std::uint32_t neighbour(std::uint32_t node, GCellDirection direction) const
+      {
+        bool exists = false;
+        switch(direction)
+        {
+          case GCellDirection::EAST: exists = horizontal(layer(node)) && x(node) + 1 < m_width; break;
+          case GCellDirection::NORTH: exists = !horizontal(layer(node)) && y(node) + 1 < m_height; break;
+          case GCellDirection::UP: exists = layer(node) + 1 < m_numLayers; break;
+        }
+        return exists ? node + stride(direction) : node;
+      }
+
+      std::uint32_t edgeTarget(std::uint32_t edge) const { return neighbour(edgeSource(edge), edgeDirection(edge)); }
+      bool edgeExists(std::uint32_t edge) const { return edgeTarget(edge) != edgeSource(edge); }
+  };
+
+} //end of namespace common
+
+#endif //COMMON_GCELL_GRID_HPP
@@ -0,0 +1,267 @@
+#ifndef COMMON_MAZE_ROUTER_HPP
+#define COMMON_MAZE_ROUTER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "congestionmap.hpp"
+#include "gcellgrid.hpp"
+#include "utils.hpp"
+
+namespace common
+{
+  //Search buffers of the maze router, sized to the grid once and reused by all the nets routed by a thread.
+  //Nodes are reset lazily: a cost is only valid when its stamp is the stamp of the current search.
+  struct MazeRouteScratch
+  {
+    std::vector<std::uint32_t> costs;
+    std::vector<std::uint32_t> parentEdges;
+    std::vector<std::uint32_t> searchStamps;
+    std::vector<std::uint32_t> treeStamps;
+    std::uint32_t searchStamp = 0;
+    std::uint32_t treeStamp = 0;
+    //bucketed priority queue, bucket f holds the nodes with cost + heuristic == f. The history costs grow
+    //without bound over the negotiated congestion iterations, so the nodes with f >= MaxBuckets go to a
+    //binary heap of (f, node) instead of growing the buckets.
+    static constexpr std::size_t MaxBuckets = 1 << 15;
+    std::vector<std::vector<std::uint32_t>> buckets;
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> heap;
+    std::vector<std::uint32_t> treeNodes;
+    std::vector<Location> pins;
+    std::size_t expandedNodes = 0;
+
+    void resize(std::size_t numNodes)
+    {
+      if(costs.size() >= numNodes)
+        return;
+      costs.resize(numNodes);
+      parentEdges.resize(numNodes);
+      searchStamps.assign(numNodes, 0);
+      treeStamps.assign(numNodes, 0);
+      searchStamp = treeStamp = 0;
+    }
+
+    //starts a new search (or tree), the stamps are cleared only when the counter wraps around
+    static std::uint32_t nextStamp(std::vector<std::uint32_t> & stamps, std::uint32_t & counter)
+    {
+      if(++counter == 0)
+      {
+        std::fill(stamps.begin(), stamps.end(), 0);
+        counter = 1;
+      }
+      return counter;
+    }
+  };
+
+  //A* maze router over the GCellGrid of a CongestionMap. Multi-pin nets are routed pin by pin, each search starts from every
+  //GCell of the tree built so far and stops at the next pin. The heuristic (Manhattan distance plus the
+  //vias to the pin layer) is consistent, so the f values popped are non decreasing and the open list is a
+  //bucket queue (Dial's algorithm), with a binary heap only for the f values past the buckets. The cost of an
+  //edge is its base cost plus its history cost, so the searches move away from the edges that have been congested.
+  class MazeRouter
+  {
+    CongestionMap & m_congestionMap;
+    const GCellGrid & m_grid;
+
+    struct Region
+    {
+      unsigned lowerX, lowerY, upperX, upperY;
+      bool contains(unsigned x, unsigned y) const { return x >= lowerX && x <= upperX && y >= lowerY && y <= upperY; }
+    };
+
+    std::uint32_t heuristic(std::uint32_t node, std::uint32_t target) const
+    {
+      auto distance = [](unsigned a, unsigned b) { return a > b ? a - b : b - a; };
+      return WireCost * (distance(m_grid.x(node), m_grid.x(target)) + distance(m_grid.y(node), m_grid.y(target))) +
+             ViaCost * distance(m_grid.layer(node), m_grid.layer(target));
+    }
+
+    std::uint32_t edgeCost(std::uint32_t edge) const
+    {
+      return (m_grid.edgeDirection(edge) == GCellDirection::UP ? ViaCost : WireCost) + m_congestionMap.historyCost(edge);
+    }
+
+    bool available(std::uint32_t edge) const
+    {
+      return m_congestionMap.available(edge);
+    }
+
+    //connects target to the current tree, appending the new edges to route
+    bool connect(std::uint32_t target, const Region & region, MazeRouteScratch & scratch, std::vector<std::uint32_t> & route) const
+    {
+      const std::uint32_t treeStamp = scratch.treeStamp;
+      if(scratch.treeStamps[target] == treeStamp)
+        return true;
+
+      const std::uint32_t searchStamp = MazeRouteScratch::nextStamp(scratch.searchStamps, scratch.searchStamp);
+      using HeapEntry = std::pair<std::uint64_t, std::uint32_t>;
+      std::size_t current = std::size_t(-1), last = 0;
+      auto push = [&](std::uint32_t node, std::uint64_t pathCost, std::uint32_t parentEdge)
+      {
+        //saturated history costs must not wrap around the 32 bits costs
+        const std::uint32_t cost = std::uint32_t(std::min<std::uint64_t>(pathCost, std::numeric_limits<std::uint32_t>::max()));
+        if(scratch.searchStamps[node] == searchStamp && scratch.costs[node] <= cost)
+          return;
+        scratch.searchStamps[node] = searchStamp;
+        scratch.costs[node] = cost;
+        scratch.parentEdges[node] = parentEdge;
+        const std::uint64_t f = std::uint64_t(cost) + heuristic(node, target);
+        if(f >= MazeRouteScratch::MaxBuckets)
+        {
+          scratch.heap.emplace_back(f, node);
+          std::push_heap(scratch.heap.begin(), scratch.heap.end(), std::greater<HeapEntry>());
+          return;
+        }
+        if(f >= scratch.buckets.size())
+          scratch.buckets.resize(f + 1);
+        scratch.buckets[f].push_back(node);
+        current = std::min<std::size_t>(current, f);
+        last = std::max<std::size_t>(last, f);
+      };
+
+      for(auto node : scratch.treeNodes)
+      {
+        push(node, 0, node);
+      }
+
+      bool found = false;
+      while(!found)
+      {
+        //the heap only holds f values past the buckets, it is used once the buckets are empty
+        std::uint32_t node;
+        std::uint64_t f;
+        if(current <= last)
+        {
+          auto & bucket = scratch.buckets[current];
+          if(bucket.empty())
+          {
+            ++current;
+            continue;
+          }
+          node = bucket.back();
+          bucket.pop_back();
+          f = current;
+        }
+        else if(!scratch.heap.empty())
+        {
+          std::pop_heap(scratch.heap.begin(), scratch.heap.end(), std::greater<HeapEntry>());
+          f = scratch.heap.back().first;
+          node = scratch.heap.back().second;
+          scratch.heap.pop_back();
+        }
+        else
+          break;
+        //stale entry, the node was reached later with a lower cost
+        if(std::uint64_t(scratch.costs[node]) + heuristic(node, target) != f)
+          continue;
+        ++scratch.expandedNodes;
+        if(node == target)
+        {
+          found = true;
+          break;
+        }
+
+        const std::uint32_t cost = scratch.costs[node];
+        for(unsigned direction = 0; direction < GCellGrid::NumDirections; ++direction)
+        {
+          const GCellDirection gcellDirection = GCellDirection(direction);
+          const std::uint32_t stride = m_grid.stride(gcellDirection);
+
+          //edge owned by node, towards its upper neighbour
+          std::uint32_t edge = m_grid.edge(node, gcellDirection);
+          std::uint32_t upper = node + stride;
+          if(m_grid.neighbour(node, gcellDirection) == upper && region.contains(m_grid.x(upper), m_grid.y(upper)) && available(edge))
+            push(upper, std::uint64_t(cost) + edgeCost(edge), edge);
+
+          //edge owned by the lower neighbour
+          if(node < stride)
+            continue;
+          std::uint32_t lower = node - stride;
+          edge = m_grid.edge(lower, gcellDirection);
+          if(m_grid.neighbour(lower, gcellDirection) == node && region.contains(m_grid.x(lower), m_grid.y(lower)) && available(edge))
+            push(lower, std::uint64_t(cost) + edgeCost(edge), edge);
+        }
+      }
+
+      for(std::size_t f = current; f <= last && f < scratch.buckets.size(); ++f)
+      {
+        scratch.buckets[f].clear();
+      }
+      scratch.heap.clear();
+      if(!found)
+        return false;
+
+      //walks back to the tree, adding the path to it
+      std::uint32_t node = target;
+      while(scratch.treeStamps[node] != treeStamp)
+      {
+        scratch.treeStamps[node] = treeStamp;
+        scratch.treeNodes.push_back(node);
+        std::uint32_t edge = scratch.parentEdges[node];
+        route.push_back(edge);
+        std::uint32_t source = m_grid.edgeSource(edge);
+        node = source == node ? m_grid.edgeTarget(edge) : source;
+      }
+      return true;
+    }
+
+    public:
+      static constexpr std::uint32_t WireCost = 1;
+      static constexpr std::uint32_t ViaCost = 2;
+
+      explicit MazeRouter(CongestionMap & congestionMap) : m_congestionMap(congestionMap), m_grid(congestionMap.grid())
+      {
+      }
+
+      //Rips up the current route of net and routes it again inside its bounding box using the edges with free
+      //capacity. On success the route is stored in the net and its usage added to the congestion map.
+      bool route(Net & net, MazeRouteScratch & scratch) const
+      {
+        m_congestionMap.removeRoute(net.route);
+        net.route.clear();
+        if(net.pins.size() < 2)
+          return true;
+
+        const Region region{net.bbox.first.first, net.bbox.first.second,
+                            std::min(net.bbox.second.first, m_grid.width() - 1), std::min(net.bbox.second.second, m_grid.height() - 1)};
+        for(auto & pin : net.pins)
+        {
+          if(!region.contains(pin.first, pin.second))
+            throw std::out_of_range("Net pin outside of the net bounding box or the routing grid: " + net.name);
+        }
+
+        scratch.resize(m_grid.numNodes());
+        //pins are connected closest to the first one first
+        auto & pins = scratch.pins;
+        pins.assign(net.pins.begin(), net.pins.end());
+        auto source = m_grid.node(pins.front().first, pins.front().second, 0);
+        std::sort(pins.begin() + 1, pins.end(), [&](const Location & a, const Location & b)
+        {
+          return heuristic(m_grid.node(a.first, a.second, 0), source) < heuristic(m_grid.node(b.first, b.second, 0), source);
+        });
+
+        scratch.treeNodes.assign(1, source);
+        scratch.treeStamps[source] = MazeRouteScratch::nextStamp(scratch.treeStamps, scratch.treeStamp);
+        for(std::size_t pin = 1; pin < pins.size(); ++pin)
+        {
+          if(!connect(m_grid.node(pins[pin].first, pins[pin].second, 0), region, scratch, net.route))
+          {
+            net.route.clear();
+            return false;
+          }
+        }
+
+        m_congestionMap.addRoute(net.route);
+        return true;
+      }
+  };
+
+} //end of namespace common
+
+#endif //COMMON_MAZE_ROUTER_HPP
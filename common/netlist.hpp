@@ -0,0 +1,281 @@
+#ifndef COMMON_NETLIST_HPP
+#define COMMON_NETLIST_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "utils.hpp"
+
+namespace common
+{
+  //Interned names: every distinct name is stored once, back to back in a single character arena,
+  //and identified by a dense id. Lookups go through an open addressing hash table of ids.
+  template <class Id = std::uint64_t>
+  class NameTable
+  {
+    std::vector<char> m_characters;
+    std::vector<std::uint64_t> m_offsets{0};
+    //id + 1 of the name in each bucket, 0 when empty. Size is a power of two.
+    std::vector<Id> m_buckets = std::vector<Id>(16, 0);
+
+    static std::uint64_t hash(const char * name, std::size_t length)
+    {
+      //FNV-1a
+      std::uint64_t value = 14695981039346656037ull;
+      for(std::size_t i = 0; i < length; ++i)
+      {
+        value = (value ^ static_cast<unsigned char>(name[i])) * 1099511628211ull;
+      }
+      return value;
+    }
+
+    bool equals(Id id, const char * name, std::size_t length) const
+    {
+      return this->length(id) == length && std::memcmp(data(id), name, length) == 0;
+    }
+
+    //bucket holding name, or the empty bucket where it would go
+    std::size_t bucket(const char * name, std::size_t length) const
+    {
+      const std::size_t mask = m_buckets.size() - 1;
+      std::size_t position = hash(name, length) & mask;
+      while(m_buckets[position] != 0 && !equals(m_buckets[position] - 1, name, length))
+      {
+        position = (position + 1) & mask;
+      }
+      return position;
+    }
+
+    void rehash()
+    {
+      std::vector<Id> buckets(m_buckets.size() * 2, 0);
+      m_buckets.swap(buckets);
+      for(Id id = 0; id < size(); ++id)
+      {
+        m_buckets[bucket(data(id), length(id))] = id + 1;
+      }
+    }
+
+    public:
+      static constexpr Id InvalidId = std::numeric_limits<Id>::max();
+
+      void reserve(std::size_t numNames, std::size_t numCharacters)
+      {
+        m_offsets.reserve(numNames + 1);
+        m_characters.reserve(numCharacters);
+      }
+
+      std::size_t size() const { return m_offsets.size() - 1; }
+
+      //id of name, adding it if it is new
+      Id intern(const std::string & name)
+      {
+        std::size_t position = bucket(name.data(), name.size());
+        if(m_buckets[position] != 0)
+          return m_buckets[position] - 1;
+
+        if(size() >= std::size_t(InvalidId) - 1)
+          throw std::overflow_error("Too many names for the id type");
+        const Id id = size();
+        m_characters.insert(m_characters.end(), name.begin(), name.end());
+        m_offsets.push_back(m_characters.size());
+        m_buckets[position] = id + 1;
+        //load factor kept under one half
+        if(2 * size() > m_buckets.size())
+          rehash();
+        return id;
+      }
+
+      //id of name, or InvalidId
+      Id find(const std::string & name) const
+      {
+        std::size_t position = bucket(name.data(), name.size());
+        return m_buckets[position] != 0 ? m_buckets[position] - 1 : InvalidId;
+      }
+
+      //names are not null terminated
+      const char * data(Id id) const { return m_characters.data() + m_offsets[id]; }
+      std::size_t length(Id id) const { return m_offsets[id + 1] - m_offsets[id]; }
+      std::string name(Id id) const { return std::string(data(id), length(id)); }
+  };
+
+  template <class Id>
+  constexpr Id NameTable<Id>::InvalidId;
+
+  //Index based netlist. Cells and nets are identified by dense ids, names are interned and the
+  //net -> pin and cell -> pin adjacency is stored as CSR arrays (built once, after the pins are added),
+  //so a net costs a few integers instead of a string and a vector of its own.
+  //Id is 64 bits by default; designs that fit use Netlist<std::uint32_t> to halve the arrays.
+  template <class Id = std::uint64_t>
+  class Netlist
+  {
+    NameTable<Id> m_cellNames;
+    NameTable<Id> m_netNames;
+    std::vector<Location> m_cellLocations;
+
+    //per pin
+    std::vector<Id> m_pinCells;
+    std::vector<Id> m_pinNets;
+    std::vector<Location> m_pinOffsets;
+
+    //pins of net are m_netPins[m_netPinOffsets[net], m_netPinOffsets[net + 1]), same for cells
+    std::vector<Id> m_netPinOffsets;
+    std::vector<Id> m_netPins;
+    std::vector<Id> m_cellPinOffsets;
+    std::vector<Id> m_cellPins;
+    bool m_adjacencyBuilt = false;
+
+    //counting sort of the pins by cell or net
+    static void buildCSR(std::size_t numKeys, const std::vector<Id> & keys, std::vector<Id> & offsets, std::vector<Id> & pins)
+    {
+      offsets.assign(numKeys + 1, 0);
+      for(auto key : keys)
+      {
+        ++offsets[key + 1];
+      }
+      for(std::size_t key = 0; key < numKeys; ++key)
+      {
+        offsets[key + 1] += offsets[key];
+      }
+      std::vector<Id> next(offsets.begin(), offsets.end() - 1);
+      pins.resize(keys.size());
+      for(std::size_t pin = 0; pin < keys.size(); ++pin)
+      {
+        pins[next[keys[pin]]++] = pin;
+      }
+    }
+
+    void checkAdjacency() const
+    {
+      if(!m_adjacencyBuilt)
+        throw std::logic_error("Netlist adjacency used before buildAdjacency()");
+    }
+
+    public:
+      static constexpr Id InvalidId = NameTable<Id>::InvalidId;
+
+      void reserve(std::size_t numCells, std::size_t numNets, std::size_t numPins)
+      {
+        m_cellNames.reserve(numCells, 0);
+        m_netNames.reserve(numNets, 0);
+        m_cellLocations.reserve(numCells);
+        m_pinCells.reserve(numPins);
+        m_pinNets.reserve(numPins);
+        m_pinOffsets.reserve(numPins);
+      }
+
+      Id addCell(const std::string & name, Location location)
+      {
+        Id cell = m_cellNames.intern(name);
+        if(cell != m_cellLocations.size())
+          throw std::runtime_error("Duplicated cell name: " + name);
+        m_cellLocations.push_back(location);
+        m_adjacencyBuilt = false;
+        return cell;
+      }
+
+      Id addNet(const std::string & name)
+      {
+        const std::size_t numNetsBefore = numNets();
+        Id net = m_netNames.intern(name);
+        if(net != numNetsBefore)
+          throw std::runtime_error("Duplicated net name: " + name);
+        m_adjacencyBuilt = false;
+        return net;
+      }
+
+      //pin of cell connected to net, at offset from the cell location
+      Id addPin(Id cell, Id net, Location offset)
+      {
+        if(cell >= numCells() || net >= numNets())
+          throw std::out_of_range("Pin references an unknown cell or net");
+        if(numPins() >= std::size_t(InvalidId) - 1)
+          throw std::overflow_error("Too many pins for the id type");
+        m_pinCells.push_back(cell);
+        m_pinNets.push_back(net);
+        m_pinOffsets.push_back(offset);
+        m_adjacencyBuilt = false;
+        return numPins() - 1;
+      }
+
+      //builds the CSR adjacency, must be called after the pins are added and before querying it
+      void buildAdjacency()
+      {
+        buildCSR(numNets(), m_pinNets, m_netPinOffsets, m_netPins);
+        buildCSR(numCells(), m_pinCells, m_cellPinOffsets, m_cellPins);
+        m_adjacencyBuilt = true;
+      }
+
+      std::size_t numCells() const { return m_cellLocations.size(); }
+      std::size_t numNets() const { return m_netNames.size(); }
+      std::size_t numPins() const { return m_pinCells.size(); }
+
+      Id findCell(const std::string & name) const { return m_cellNames.find(name); }
+      Id findNet(const std::string & name) const { return m_netNames.find(name); }
+      std::string cellName(Id cell) const { return m_cellNames.name(cell); }
+      std::string netName(Id net) const { return m_netNames.name(net); }
+
+      Location cellLocation(Id cell) const { return m_cellLocations[cell]; }
+      void setCellLocation(Id cell, Location location) { m_cellLocations[cell] = location; }
+
+      Id pinCell(Id pin) const { return m_pinCells[pin]; }
+      Id pinNet(Id pin) const { return m_pinNets[pin]; }
+      Location pinLocation(Id pin) const
+      {
+        Location cell = m_cellLocations[m_pinCells[pin]];
+        return Location{cell.first + m_pinOffsets[pin].first, cell.second + m_pinOffsets[pin].second};
+      }
+
+      //pins of net are netPin(position) for position in [netPinsBegin(net), netPinsEnd(net))
+      Id netPinsBegin(Id net) const { checkAdjacency(); return m_netPinOffsets[net]; }
+      Id netPinsEnd(Id net) const { checkAdjacency(); return m_netPinOffsets[net + 1]; }
+      Id netPin(Id position) const { return m_netPins[position]; }
+
+      //pins of cell are cellPin(position) for position in [cellPinsBegin(cell), cellPinsEnd(cell))
+      Id cellPinsBegin(Id cell) const { checkAdjacency(); return m_cellPinOffsets[cell]; }
+      Id cellPinsEnd(Id cell) const { checkAdjacency(); return m_cellPinOffsets[cell + 1]; }
+      Id cellPin(Id position) const { return m_cellPins[position]; }
+
+      BoundingBox netBoundingBox(Id net) const
+      {
+        BoundingBox bbox{Location{std::numeric_limits<unsigned>::max(), std::numeric_limits<unsigned>::max()}, Location{0, 0}};
+        for(Id position = netPinsBegin(net); position < netPinsEnd(net); ++position)
+        {
+          Location location = pinLocation(netPin(position));
+          bbox.first.first = std::min(bbox.first.first, location.first);
+          bbox.first.second = std::min(bbox.first.second, location.second);
+          bbox.second.first = std::max(bbox.second.first, location.first);
+          bbox.second.second = std::max(bbox.second.second, location.second);
+        }
+        return netPinsBegin(net) == netPinsEnd(net) ? BoundingBox{} : bbox;
+      }
+
+      //Net handed to the routers: pins and bounding box in GCells of gcellWidth x gcellHeight.
+      //Only the nets being routed are materialized.
+      Net routingNet(Id net, unsigned gcellWidth, unsigned gcellHeight) const
+      {
+        Net routing{netName(net), unsigned(netPinsEnd(net) - netPinsBegin(net)), BoundingBox{}, {}, {}};
+        for(Id position = netPinsBegin(net); position < netPinsEnd(net); ++position)
+        {
+          Location location = pinLocation(netPin(position));
+          routing.pins.emplace_back(location.first / gcellWidth, location.second / gcellHeight);
+        }
+        BoundingBox bbox = netBoundingBox(net);
+        routing.bbox = BoundingBox{Location{bbox.first.first / gcellWidth, bbox.first.second / gcellHeight},
+                                   Location{bbox.second.first / gcellWidth, bbox.second.second / gcellHeight}};
+        return routing;
+      }
+  };
+
+  template <class Id>
+  constexpr Id Netlist<Id>::InvalidId;
+
+} //end of namespace common
+
+#endif //COMMON_NETLIST_HPP
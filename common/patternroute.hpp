@@ -0,0 +1,99 @@
+#ifndef COMMON_PATTERN_ROUTE_HPP
+#define COMMON_PATTERN_ROUTE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "gcellgrid.hpp"
+#include "utils.hpp"
+
+//Pattern routes: fixed shaped routes (L shapes) between two GCells of the pin layer, built edge by edge
+//on the GCellGrid. They are cheap to build and are the candidate routes of the greedy and ILP routers.
+
+namespace common
+{
+  //vias of the GCell (x, y) between two layers
+  inline void appendViaStack(const GCellGrid & grid, unsigned x, unsigned y, unsigned fromLayer, unsigned toLayer, std::vector<std::uint32_t> & route)
+  {
+    for(unsigned layer = std::min(fromLayer, toLayer); layer < std::max(fromLayer, toLayer); ++layer)
+    {
+      route.push_back(grid.edge(grid.node(x, y, layer), GCellDirection::UP));
+    }
+  }
+
+  //straight wire on layer from (x, y) to (x + length, y) or (x, y + length), in the direction of the layer
+  inline void appendWire(const GCellGrid & grid, unsigned x, unsigned y, unsigned layer, unsigned length, std::vector<std::uint32_t> & route)
+  {
+    const GCellDirection direction = grid.horizontal(layer) ? GCellDirection::EAST : GCellDirection::NORTH;
+    std::uint32_t node = grid.node(x, y, layer);
+    for(unsigned step = 0; step < length; ++step, node += grid.stride(direction))
+    {
+      route.push_back(grid.edge(node, direction));
+    }
+  }
+
+  //L shaped route between two pins, with the horizontal segment on horizontalLayer and the vertical one on
+  //verticalLayer (an adjacent layer). The horizontal segment goes first (at the height of from) or last.
+  inline void appendLShape(const GCellGrid & grid, Location from, Location to, unsigned horizontalLayer, unsigned verticalLayer,
+                           bool horizontalFirst, std::vector<std::uint32_t> & route)
+  {
+    if(from == to)
+      return;
+
+    const unsigned cornerY = horizontalFirst ? from.second : to.second;
+    const unsigned cornerX = horizontalFirst ? to.first : from.first;
+    const Location horizontalStart{std::min(from.first, to.first), cornerY};
+    const Location verticalStart{cornerX, std::min(from.second, to.second)};
+    const unsigned width = std::max(from.first, to.first) - horizontalStart.first;
+    const unsigned height = std::max(from.second, to.second) - verticalStart.second;
+
+    if(height == 0)
+    {
+      appendViaStack(grid, from.first, from.second, 0, horizontalLayer, route);
+      appendWire(grid, horizontalStart.first, horizontalStart.second, horizontalLayer, width, route);
+      appendViaStack(grid, to.first, to.second, 0, horizontalLayer, route);
+      return;
+    }
+    if(width == 0)
+    {
+      appendViaStack(grid, from.first, from.second, 0, verticalLayer, route);
+      appendWire(grid, verticalStart.first, verticalStart.second, verticalLayer, height, route);
+      appendViaStack(grid, to.first, to.second, 0, verticalLayer, route);
+      return;
+    }
+
+    const Location & horizontalPin = horizontalFirst ? from : to;
+    const Location & verticalPin = horizontalFirst ? to : from;
+    appendViaStack(grid, horizontalPin.first, horizontalPin.second, 0, horizontalLayer, route);
+    appendWire(grid, horizontalStart.first, horizontalStart.second, horizontalLayer, width, route);
+    appendViaStack(grid, cornerX, cornerY, horizontalLayer, verticalLayer, route);
+    appendWire(grid, verticalStart.first, verticalStart.second, verticalLayer, height, route);
+    appendViaStack(grid, verticalPin.first, verticalPin.second, 0, verticalLayer, route);
+  }
+
+  //(horizontal, vertical) pairs of adjacent layers the L shapes can use, lowest layers first. With a single
+  //layer only the horizontal one is returned, with a vertical layer out of the grid.
+  inline std::vector<std::pair<unsigned, unsigned>> lShapeLayers(const GCellGrid & grid)
+  {
+    std::vector<std::pair<unsigned, unsigned>> layers;
+    for(unsigned horizontalLayer = 0; horizontalLayer < grid.numLayers(); horizontalLayer += 2)
+    {
+      if(horizontalLayer > 0)
+        layers.emplace_back(horizontalLayer, horizontalLayer - 1);
+      if(horizontalLayer + 1 < grid.numLayers() || grid.numLayers() == 1)
+        layers.emplace_back(horizontalLayer, horizontalLayer + 1);
+    }
+    return layers;
+  }
+
+  //sorts the edges of a route and removes the ones used twice by different connections
+  inline void removeDuplicatedEdges(std::vector<std::uint32_t> & route)
+  {
+    std::sort(route.begin(), route.end());
+    route.erase(std::unique(route.begin(), route.end()), route.end());
+  }
+
+} //end of namespace common
+
+#endif //COMMON_PATTERN_ROUTE_HPP
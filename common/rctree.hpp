@@ -0,0 +1,193 @@
+#ifndef COMMON_RC_TREE_HPP
+#define COMMON_RC_TREE_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace common
+{
+  //Parasitics (RC trees) of many nets stored in flat arrays. The nodes of a tree are contiguous,
+  //the first node is the driver (root) and every node comes after its parent.
+  class RCTreeArena
+  {
+    std::vector<std::size_t> m_treeOffsets{0};
+    std::vector<double> m_driverResistances;
+    //per node: parent index inside the tree, resistance of the wire to the parent and capacitance to ground
+    std::vector<unsigned> m_parents;
+    std::vector<double> m_resistances;
+    std::vector<double> m_capacitances;
+
+    public:
+      void reserve(std::size_t numTrees, std::size_t numNodes)
+      {
+        m_treeOffsets.reserve(numTrees + 1);
+        m_driverResistances.reserve(numTrees);
+        m_parents.reserve(numNodes);
+        m_resistances.reserve(numNodes);
+        m_capacitances.reserve(numNodes);
+      }
+
+      //starts a new tree with its root node, the following addNode() calls add nodes to it
+      unsigned addTree(double driverResistance, double rootCapacitance)
+      {
+        m_treeOffsets.push_back(m_treeOffsets.back());
+        m_driverResistances.push_back(driverResistance);
+        addNode(0, 0.0, rootCapacitance);
+        return numTrees() - 1;
+      }
+
+      //returns the index of the node inside the last tree
+      unsigned addNode(unsigned parent, double resistance, double capacitance)
+      {
+        if(numTrees() == 0 || (treeSize(numTrees() - 1) > 0 && parent >= treeSize(numTrees() - 1)))
+          throw std::out_of_range("RC tree node parent must be added before the node");
+
+        m_parents.push_back(parent);
+        m_resistances.push_back(resistance);
+        m_capacitances.push_back(capacitance);
+        return m_treeOffsets.back()++ - m_treeOffsets[numTrees() - 1];
+      }
+
+      std::size_t numTrees() const { return m_treeOffsets.size() - 1; }
+      std::size_t numNodes() const { return m_parents.size(); }
+
+      //nodes of tree are [treeBegin(tree), treeEnd(tree)) in the arena
+      std::size_t treeBegin(unsigned tree) const { return m_treeOffsets[tree]; }
+      std::size_t treeEnd(unsigned tree) const { return m_treeOffsets[tree + 1]; }
+      std::size_t treeSize(unsigned tree) const { return treeEnd(tree) - treeBegin(tree); }
+
+      double driverResistance(unsigned tree) const { return m_driverResistances[tree]; }
+      const unsigned * parents(unsigned tree) const { return m_parents.data() + treeBegin(tree); }
+      const double * resistances(unsigned tree) const { return m_resistances.data() + treeBegin(tree); }
+      const double * capacitances(unsigned tree) const { return m_capacitances.data() + treeBegin(tree); }
+  };
+
+  enum class LoadModel {LUMPED_CAPACITANCE, EFFECTIVE_CAPACITANCE};
+  enum class WireDelayModel {ELMORE, D2M};
+
+  //scratch buffers of the RC tree kernels, reused among the nets evaluated by a thread
+  struct RCTreeScratch
+  {
+    std::vector<double> downstream;
+    std::vector<double> firstMoments;
+    std::vector<double> secondMoments;
+    std::vector<double> pathResistances;
+  };
+
+  //load seen by the driver: total capacitance or the capacitance shielded by the wire resistance,
+  //each capacitance weighted by driverResistance / (driverResistance + resistance from the root)
+  template <LoadModel Load>
+  double driverLoad(const RCTreeArena & arena, unsigned tree, RCTreeScratch & scratch)
+  {
+    const std::size_t size = arena.treeSize(tree);
+    const unsigned * parents = arena.parents(tree);
+    const double * resistances = arena.resistances(tree);
+    const double * capacitances = arena.capacitances(tree);
+    const double driverResistance = arena.driverResistance(tree);
+
+    double load = 0.0;
+    if(Load == LoadModel::LUMPED_CAPACITANCE || driverResistance <= 0.0)
+    {
+      for(std::size_t node = 0; node < size; ++node)
+      {
+        load += capacitances[node];
+      }
+      return load;
+    }
+
+    auto & pathResistances = scratch.pathResistances;
+    pathResistances.assign(size, 0.0);
+    for(std::size_t node = 1; node < size; ++node)
+    {
+      pathResistances[node] = pathResistances[parents[node]] + resistances[node];
+    }
+    for(std::size_t node = 0; node < size; ++node)
+    {
+      load += capacitances[node] * driverResistance / (driverResistance + pathResistances[node]);
+    }
+    return load;
+  }
+
+  //Delay from the driver input to every node of tree: driver resistance times the driver load plus the wire delay.
+  //Elmore is the first moment m1 of the impulse response, D2M is ln(2) * m1^2 / sqrt(m2).
+  //Both moments are computed in two linear passes: downstream sums from the leaves to the root
+  //and path sums from the root to the leaves.
+  template <LoadModel Load, WireDelayModel Wire>
+  void computeNetDelays(const RCTreeArena & arena, unsigned tree, RCTreeScratch & scratch, double * delays)
+  {
+    const std::size_t size = arena.treeSize(tree);
+    const unsigned * parents = arena.parents(tree);
+    const double * resistances = arena.resistances(tree);
+    const double * capacitances = arena.capacitances(tree);
+
+    auto & downstream = scratch.downstream;
+    auto & firstMoments = scratch.firstMoments;
+
+    //m1(i) = sum over the wires e from the root to i of R(e) * downstream capacitance of e
+    downstream.assign(capacitances, capacitances + size);
+    for(std::size_t node = size; node-- > 1;)
+    {
+      downstream[parents[node]] += downstream[node];
+    }
+    firstMoments.assign(size, 0.0);
+    for(std::size_t node = 1; node < size; ++node)
+    {
+      firstMoments[node] = firstMoments[parents[node]] + resistances[node] * downstream[node];
+    }
+
+    const double driverDelay = arena.driverResistance(tree) * driverLoad<Load>(arena, tree, scratch);
+    if(Wire == WireDelayModel::ELMORE)
+    {
+      for(std::size_t node = 0; node < size; ++node)
+      {
+        delays[node] = driverDelay + firstMoments[node];
+      }
+      return;
+    }
+
+    //m2(i) = sum over the wires e from the root to i of R(e) * downstream sum of C * m1
+    for(std::size_t node = 0; node < size; ++node)
+    {
+      downstream[node] = capacitances[node] * firstMoments[node];
+    }
+    for(std::size_t node = size; node-- > 1;)
+    {
+      downstream[parents[node]] += downstream[node];
+    }
+    auto & secondMoments = scratch.secondMoments;
+    secondMoments.assign(size, 0.0);
+    delays[0] = driverDelay;
+    for(std::size_t node = 1; node < size; ++node)
+    {
+      secondMoments[node] = secondMoments[parents[node]] + resistances[node] * downstream[node];
+      double wireDelay = secondMoments[node] > 0.0 ? std::log(2.0) * firstMoments[node] * firstMoments[node] / std::sqrt(secondMoments[node]) : 0.0;
+      delays[node] = driverDelay + wireDelay;
+    }
+  }
+
+  //Evaluates all the nets of the arena in parallel. delays is indexed as the arena nodes.
+  template <LoadModel Load, WireDelayModel Wire>
+  void computeNetDelays(const RCTreeArena & arena, std::vector<double> & delays)
+  {
+    delays.resize(arena.numNodes());
+    const std::ptrdiff_t numTrees = arena.numTrees();
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+      RCTreeScratch scratch;
+#ifdef _OPENMP
+      #pragma omp for schedule(dynamic, 256)
+#endif
+      for(std::ptrdiff_t tree = 0; tree < numTrees; ++tree)
+      {
+        computeNetDelays<Load, Wire>(arena, tree, scratch, delays.data() + arena.treeBegin(tree));
+      }
+    }
+  }
+
+} //end of namespace common
+
+#endif //COMMON_RC_TREE_HPP
@@ -0,0 +1,213 @@
+#ifndef COMMON_ROUTE_SELECTION_HPP
+#define COMMON_ROUTE_SELECTION_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+//Route selection ILP of a cluster of nets: every net picks exactly one of its candidate routes and
+//every edge used over its free capacity pays a penalty per extra route.
+//
+//  minimize    sum cost(n,c) x(n,c) + overflowPenalty * sum o(e)
+//  subject to  sum_c x(n,c) = 1                              for every net n
+//              sum_(n,c) uses(n,c,e) x(n,c) - o(e) <= free(e)  for every edge e
+//              x(n,c) binary, o(e) >= 0
+
+namespace common
+{
+  struct RouteCandidate
+  {
+    //edges as indices in [0, RouteSelectionProblem::freeCapacities.size())
+    std::vector<std::uint32_t> edges;
+    std::uint64_t cost;
+  };
+
+  struct RouteSelectionProblem
+  {
+    std::vector<std::vector<RouteCandidate>> candidates;
+    //capacity left on each edge by the routes outside of the cluster
+    std::vector<std::uint32_t> freeCapacities;
+    std::uint64_t overflowPenalty;
+  };
+
+  struct RouteSelection
+  {
+    //candidate picked by every net
+    std::vector<unsigned> choices;
+    std::uint64_t cost = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t overflow = 0;
+    //false when the time budget ran out before the search space was exhausted
+    bool optimal = false;
+    std::size_t exploredNodes = 0;
+  };
+
+  //cost and overflow of a complete selection
+  inline RouteSelection evaluateRouteSelection(const RouteSelectionProblem & problem, const std::vector<unsigned> & choices)
+  {
+    RouteSelection selection;
+    selection.choices = choices;
+    selection.cost = 0;
+    std::vector<std::uint32_t> usages(problem.freeCapacities.size(), 0);
+    for(std::size_t net = 0; net < choices.size(); ++net)
+    {
+      const RouteCandidate & candidate = problem.candidates[net][choices[net]];
+      selection.cost += candidate.cost;
+      for(auto edge : candidate.edges)
+      {
+        if(++usages[edge] > problem.freeCapacities[edge])
+          ++selection.overflow;
+      }
+    }
+    selection.cost += problem.overflowPenalty * selection.overflow;
+    return selection;
+  }
+
+  //ILP solver backend of the ILP router
+  class RouteSelectionSolver
+  {
+    public:
+      virtual ~RouteSelectionSolver()
+      {
+      }
+
+      //warmStart is a selection to start from (may be empty), the solver returns the best selection found within budget
+      virtual RouteSelection solve(const RouteSelectionProblem & problem, const std::vector<unsigned> & warmStart,
+                                   std::chrono::steady_clock::duration budget) = 0;
+  };
+
+  //Depth first branch and bound over the choice of each net. The bound of a partial selection is its cost
+  //plus the cheapest candidate of every net still to choose (the overflow can only grow). The incumbent
+  //starts from the warm start, or from a greedy selection, so a good solution is returned even if the
+  //budget runs out early.
+  class BranchAndBoundRouteSelectionSolver : public RouteSelectionSolver
+  {
+    //the clock is read once every this many nodes
+    static constexpr std::size_t DeadlineCheckPeriod = 256;
+
+    struct Search
+    {
+      const RouteSelectionProblem & problem;
+      std::vector<std::vector<unsigned>> order;
+      std::vector<std::uint64_t> remainingBounds;
+      std::vector<std::uint32_t> usages;
+      std::vector<unsigned> choices;
+      RouteSelection best;
+      std::chrono::steady_clock::time_point deadline;
+      bool timeout = false;
+
+      std::uint64_t extraOverflow(const RouteCandidate & candidate) const
+      {
+        std::uint64_t overflow = 0;
+        for(auto edge : candidate.edges)
+        {
+          if(usages[edge] >= problem.freeCapacities[edge])
+            ++overflow;
+        }
+        return overflow;
+      }
+
+      void branch(std::size_t net, std::uint64_t cost)
+      {
+        if(++best.exploredNodes % DeadlineCheckPeriod == 0 && std::chrono::steady_clock::now() > deadline)
+          timeout = true;
+        if(timeout)
+          return;
+
+        if(net == problem.candidates.size())
+        {
+          if(cost < best.cost)
+          {
+            best.cost = cost;
+            best.choices = choices;
+          }
+          return;
+        }
+
+        for(auto choice : order[net])
+        {
+          const RouteCandidate & candidate = problem.candidates[net][choice];
+          std::uint64_t childCost = cost + candidate.cost + problem.overflowPenalty * extraOverflow(candidate);
+          if(childCost + remainingBounds[net + 1] >= best.cost)
+            continue;
+
+          for(auto edge : candidate.edges) ++usages[edge];
+          choices[net] = choice;
+          branch(net + 1, childCost);
+          for(auto edge : candidate.edges) --usages[edge];
+          if(timeout)
+            return;
+        }
+      }
+    };
+
+    public:
+      RouteSelection solve(const RouteSelectionProblem & problem, const std::vector<unsigned> & warmStart,
+                           std::chrono::steady_clock::duration budget) override
+      {
+        const std::size_t numNets = problem.candidates.size();
+        Search search{problem, std::vector<std::vector<unsigned>>(numNets), std::vector<std::uint64_t>(numNets + 1, 0),
+                      std::vector<std::uint32_t>(problem.freeCapacities.size(), 0), std::vector<unsigned>(numNets, 0),
+                      RouteSelection(), std::chrono::steady_clock::now() + budget};
+
+        //candidates are tried cheapest first
+        for(std::size_t net = numNets; net-- > 0;)
+        {
+          if(problem.candidates[net].empty())
+            throw std::runtime_error("Route selection net without candidates");
+          auto & order = search.order[net];
+          order.resize(problem.candidates[net].size());
+          std::iota(order.begin(), order.end(), 0);
+          std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b) { return problem.candidates[net][a].cost < problem.candidates[net][b].cost; });
+          search.remainingBounds[net] = search.remainingBounds[net + 1] + problem.candidates[net][order.front()].cost;
+        }
+
+        //incumbent: the warm start when it is valid, otherwise the greedy selection given by the cheapest
+        //candidate of each net considering the overflow of the nets before it
+        std::vector<unsigned> initial(numNets);
+        bool valid = warmStart.size() == numNets;
+        for(std::size_t net = 0; valid && net < numNets; ++net)
+        {
+          valid = warmStart[net] < problem.candidates[net].size();
+        }
+        if(valid)
+        {
+          initial = warmStart;
+        }
+        else
+        {
+          for(std::size_t net = 0; net < numNets; ++net)
+          {
+            std::uint64_t bestCost = std::numeric_limits<std::uint64_t>::max();
+            for(unsigned choice = 0; choice < problem.candidates[net].size(); ++choice)
+            {
+              const RouteCandidate & candidate = problem.candidates[net][choice];
+              std::uint64_t cost = candidate.cost + problem.overflowPenalty * search.extraOverflow(candidate);
+              if(cost < bestCost)
+              {
+                bestCost = cost;
+                initial[net] = choice;
+              }
+            }
+            for(auto edge : problem.candidates[net][initial[net]].edges) ++search.usages[edge];
+          }
+          std::fill(search.usages.begin(), search.usages.end(), 0);
+        }
+        search.best = evaluateRouteSelection(problem, initial);
+
+        search.branch(0, 0);
+
+        RouteSelection selection = evaluateRouteSelection(problem, search.best.choices);
+        selection.optimal = !search.timeout;
+        selection.exploredNodes = search.best.exploredNodes;
+        return selection;
+      }
+  };
+
+} //end of namespace common
+
+#endif //COMMON_ROUTE_SELECTION_HPP
@@ -0,0 +1,80 @@
+#ifndef COMMON_SLACK_STATISTICS_HPP
+#define COMMON_SLACK_STATISTICS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "utils.hpp"
+
+//Bulk slack queries as vectorized (OpenMP simd) reductions over cache line aligned slack arrays
+
+namespace common
+{
+  //worst negative slack (WNS), 0 if there is no violation
+  inline double worstNegativeSlack(const AlignedVector<double> & slacks)
+  {
+    const double * data = slacks.data();
+    const std::ptrdiff_t size = slacks.size();
+    double worst = 0.0;
+#ifdef _OPENMP
+    #pragma omp simd aligned(data : 64) reduction(min : worst)
+#endif
+    for(std::ptrdiff_t i = 0; i < size; ++i)
+    {
+      worst = std::min(worst, data[i]);
+    }
+    return worst;
+  }
+
+  //total negative slack (TNS), the sum of all the negative slacks
+  inline double totalNegativeSlack(const AlignedVector<double> & slacks)
+  {
+    const double * data = slacks.data();
+    const std::ptrdiff_t size = slacks.size();
+    double total = 0.0;
+#ifdef _OPENMP
+    #pragma omp simd aligned(data : 64) reduction(+ : total)
+#endif
+    for(std::ptrdiff_t i = 0; i < size; ++i)
+    {
+      total += std::min(data[i], 0.0);
+    }
+    return total;
+  }
+
+  inline std::size_t numViolations(const AlignedVector<double> & slacks)
+  {
+    const double * data = slacks.data();
+    const std::ptrdiff_t size = slacks.size();
+    std::ptrdiff_t violations = 0;
+#ifdef _OPENMP
+    #pragma omp simd aligned(data : 64) reduction(+ : violations)
+#endif
+    for(std::ptrdiff_t i = 0; i < size; ++i)
+    {
+      violations += data[i] < 0.0;
+    }
+    return violations;
+  }
+
+  //numBins bins of the same width in [lower, upper), slacks out of the range go to the first/last bin
+  inline std::vector<std::size_t> slackHistogram(const AlignedVector<double> & slacks, double lower, double upper, std::size_t numBins)
+  {
+    std::vector<std::size_t> histogram(numBins, 0);
+    if(numBins == 0 || !(lower < upper))
+      return histogram;
+
+    const double binsPerSlack = numBins / (upper - lower);
+    const double lastBin = numBins - 1;
+    for(auto slack : slacks)
+    {
+      double bin = std::max(0.0, std::min(lastBin, (slack - lower) * binsPerSlack));
+      ++histogram[static_cast<std::size_t>(bin)];
+    }
+    return histogram;
+  }
+
+} //end of namespace common
+
+#endif //COMMON_SLACK_STATISTICS_HPP
@@ -0,0 +1,405 @@
+#ifndef COMMON_STEINER_TREE_HPP
+#define COMMON_STEINER_TREE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "utils.hpp"
+
+namespace common
+{
+  //Rectilinear Steiner tree of a net: the pins (in the given order) followed by the Steiner points,
+  //and the edges between them. Edges are rectilinear connections, routed as L shapes.
+  struct SteinerTree
+  {
+    std::vector<Location> points;
+    std::vector<std::pair<unsigned, unsigned>> edges;
+
+    static std::uint64_t distance(const Location & a, const Location & b)
+    {
+      return std::uint64_t(std::max(a.first, b.first) - std::min(a.first, b.first)) + (std::max(a.second, b.second) - std::min(a.second, b.second));
+    }
+
+    std::uint64_t wirelength() const
+    {
+      std::uint64_t length = 0;
+      for(auto & edge : edges)
+      {
+        length += distance(points[edge.first], points[edge.second]);
+      }
+      return length;
+    }
+  };
+
+  //Lookup table of optimal Steiner topologies for nets of up to MaxDegree pins (as FLUTE).
+  //
+  //A net of degree d is described by its position sequence: the pins sorted by x and the y rank of each
+  //one. Given the sequence, the length of any tree over the Hanan grid is a linear combination of the d-1
+  //horizontal and d-1 vertical gaps between consecutive coordinates, so each tree is a wirelength vector.
+  //The table keeps, for every position sequence, the vectors no other vector dominates (potentially optimal
+  //wirelength vectors) and their topologies: the optimal tree of a net is the one of the vector with the
+  //smallest dot product with the gaps of the net.
+  //
+  //The table is generated the first time it is used by enumerating (Pruefer sequences) the spanning trees
+  //of the pins plus up to d-2 Hanan grid points, which by Hanan's theorem contain a minimum tree.
+  class SteinerLookupTable
+  {
+    public:
+      static constexpr unsigned MaxDegree = 4;
+      static constexpr unsigned MaxGaps = 2 * (MaxDegree - 1);
+      static constexpr unsigned MaxNodes = 2 * MaxDegree - 2;
+
+      struct Topology
+      {
+        //multiplicity of every horizontal gap, then of every vertical gap
+        std::array<std::uint8_t, MaxGaps> weights;
+        //Steiner points as (x rank, y rank)
+        std::uint8_t numSteinerPoints;
+        std::array<std::pair<std::uint8_t, std::uint8_t>, MaxDegree - 2> steinerPoints;
+        //nodes: pins in x order, then Steiner points
+        std::array<std::pair<std::uint8_t, std::uint8_t>, MaxNodes - 1> edges;
+        std::uint8_t numEdges;
+      };
+
+    private:
+      //table[degree][sequence] where sequence encodes the y ranks in base degree
+      std::array<std::vector<std::vector<Topology>>, MaxDegree + 1> m_tables;
+
+      static unsigned encode(const unsigned * yRanks, unsigned degree)
+      {
+        unsigned code = 0;
+        for(unsigned pin = 0; pin < degree; ++pin)
+        {
+          code = code * degree + yRanks[pin];
+        }
+        return code;
+      }
+
+      static bool dominates(const Topology & a, const Topology & b, unsigned numGaps)
+      {
+        for(unsigned gap = 0; gap < numGaps; ++gap)
+        {
+          if(a.weights[gap] > b.weights[gap])
+            return false;
+        }
+        return true;
+      }
+
+      //adds topology to the potentially optimal ones unless it is dominated, removing the ones it dominates
+      static void insert(std::vector<Topology> & topologies, const Topology & topology, unsigned numGaps)
+      {
+        for(auto & other : topologies)
+        {
+          if(dominates(other, topology, numGaps))
+            return;
+        }
+        topologies.erase(std::remove_if(topologies.begin(), topologies.end(),
+                                        [&](const Topology & other) { return dominates(topology, other, numGaps); }), topologies.end());
+        topologies.push_back(topology);
+      }
+
+      //tree of the Pruefer sequence over nodes (pins in x order, then Steiner points), as (x rank, y rank)
+      static Topology decode(const std::vector<unsigned> & sequence, const std::vector<std::pair<unsigned, unsigned>> & nodes,
+                             unsigned degree, std::vector<unsigned> & nodeDegrees)
+      {
+        Topology topology{};
+        topology.numSteinerPoints = nodes.size() - degree;
+        for(unsigned point = 0; point < topology.numSteinerPoints; ++point)
+        {
+          topology.steinerPoints[point] = std::make_pair(std::uint8_t(nodes[degree + point].first), std::uint8_t(nodes[degree + point].second));
+        }
+
+        auto addEdge = [&](unsigned a, unsigned b)
+        {
+          topology.edges[topology.numEdges++] = std::make_pair(std::uint8_t(a), std::uint8_t(b));
+          for(unsigned x = std::min(nodes[a].first, nodes[b].first); x < std::max(nodes[a].first, nodes[b].first); ++x) ++topology.weights[x];
+          for(unsigned y = std::min(nodes[a].second, nodes[b].second); y < std::max(nodes[a].second, nodes[b].second); ++y) ++topology.weights[degree - 1 + y];
+        };
+        for(auto node : sequence)
+        {
+          unsigned leaf = std::find(nodeDegrees.begin(), nodeDegrees.end(), 1) - nodeDegrees.begin();
+          addEdge(leaf, node);
+          --nodeDegrees[leaf];
+          --nodeDegrees[node];
+        }
+        unsigned first = std::find(nodeDegrees.begin(), nodeDegrees.end(), 1) - nodeDegrees.begin();
+        unsigned second = std::find(nodeDegrees.begin() + first + 1, nodeDegrees.end(), 1) - nodeDegrees.begin();
+        addEdge(first, second);
+        return topology;
+      }
+
+      static void generate(unsigned degree, const unsigned * yRanks, std::vector<Topology> & topologies)
+      {
+        const unsigned numGaps = 2 * (degree - 1);
+        std::vector<std::pair<unsigned, unsigned>> hanan;
+        for(unsigned x = 0; x < degree; ++x)
+          for(unsigned y = 0; y < degree; ++y)
+            if(yRanks[x] != y)
+              hanan.emplace_back(x, y);
+
+        std::vector<std::pair<unsigned, unsigned>> nodes;
+        std::vector<unsigned> subset;
+        std::vector<unsigned> sequence;
+        std::vector<unsigned> nodeDegrees;
+        //subsets of Hanan points of increasing size, in lexicographic order
+        for(unsigned numSteiner = 0; numSteiner + 2 <= degree; ++numSteiner)
+        {
+          subset.resize(numSteiner);
+          std::iota(subset.begin(), subset.end(), 0);
+          while(true)
+          {
+            nodes.clear();
+            for(unsigned pin = 0; pin < degree; ++pin) nodes.emplace_back(pin, yRanks[pin]);
+            for(auto point : subset) nodes.push_back(hanan[point]);
+
+            //every labelled tree of k nodes is a Pruefer sequence of k-2 labels, where a node appears its degree - 1 times
+            const unsigned numNodes = nodes.size();
+            sequence.assign(numNodes - 2, 0);
+            while(true)
+            {
+              nodeDegrees.assign(numNodes, 1);
+              for(auto node : sequence) ++nodeDegrees[node];
+              //a Steiner point of degree 1 or 2 can be removed without making the tree longer
+              if(std::all_of(nodeDegrees.begin() + degree, nodeDegrees.end(), [](unsigned nodeDegree) { return nodeDegree >= 3; }))
+                insert(topologies, decode(sequence, nodes, degree, nodeDegrees), numGaps);
+
+              unsigned position = 0;
+              while(position < sequence.size() && ++sequence[position] == numNodes)
+              {
+                sequence[position++] = 0;
+              }
+              if(position == sequence.size())
+                break;
+            }
+
+            int position = int(numSteiner) - 1;
+            while(position >= 0 && subset[position] == hanan.size() - numSteiner + position)
+            {
+              --position;
+            }
+            if(position < 0)
+              break;
+            ++subset[position];
+            for(unsigned i = position + 1; i < numSteiner; ++i) subset[i] = subset[i - 1] + 1;
+          }
+        }
+      }
+
+      SteinerLookupTable()
+      {
+        for(unsigned degree = 2; degree <= MaxDegree; ++degree)
+        {
+          unsigned numCodes = 1;
+          for(unsigned pin = 0; pin < degree; ++pin) numCodes *= degree;
+          m_tables[degree].resize(numCodes);
+
+          std::array<unsigned, MaxDegree> yRanks;
+          for(unsigned pin = 0; pin < degree; ++pin) yRanks[pin] = pin;
+          do
+          {
+            generate(degree, yRanks.data(), m_tables[degree][encode(yRanks.data(), degree)]);
+          } while(std::next_permutation(yRanks.begin(), yRanks.begin() + degree));
+        }
+      }
+
+    public:
+      static const SteinerLookupTable & instance()
+      {
+        static const SteinerLookupTable table;
+        return table;
+      }
+
+      const std::vector<Topology> & topologies(unsigned degree, const unsigned * yRanks) const
+      {
+        return m_tables[degree][encode(yRanks, degree)];
+      }
+
+      //optimal tree of 2 to MaxDegree pins
+      SteinerTree build(const std::vector<Location> & pins) const
+      {
+        const unsigned degree = pins.size();
+        std::array<unsigned, MaxDegree> byX, byY, yRanks;
+        for(unsigned pin = 0; pin < degree; ++pin) byX[pin] = byY[pin] = pin;
+        //insertion sort, at most MaxDegree pins (std::sort also trips -Warray-bounds on the fixed arrays in optimized builds)
+        auto sortPins = [degree](std::array<unsigned, MaxDegree> & order, auto less)
+        {
+          for(unsigned i = 1; i < degree; ++i)
+            for(unsigned j = i; j > 0 && less(order[j], order[j - 1]); --j)
+              std::swap(order[j], order[j - 1]);
+        };
+        sortPins(byX, [&](unsigned a, unsigned b) { return pins[a].first < pins[b].first; });
+        sortPins(byY, [&](unsigned a, unsigned b) { return pins[a].second < pins[b].second; });
+        std::array<unsigned, MaxDegree> rankOfPin;
+        for(unsigned rank = 0; rank < degree; ++rank) rankOfPin[byY[rank]] = rank;
+        for(unsigned rank = 0; rank < degree; ++rank) yRanks[rank] = rankOfPin[byX[rank]];
+
+        std::array<std::uint64_t, MaxGaps> gaps;
+        for(unsigned gap = 0; gap + 1 < degree; ++gap)
+        {
+          gaps[gap] = pins[byX[gap + 1]].first - pins[byX[gap]].first;
+          gaps[degree - 1 + gap] = pins[byY[gap + 1]].second - pins[byY[gap]].second;
+        }
+
+        const Topology * best = nullptr;
+        std::uint64_t bestLength = std::numeric_limits<std::uint64_t>::max();
+        for(auto & topology : topologies(degree, yRanks.data()))
+        {
+          std::uint64_t length = 0;
+          for(unsigned gap = 0; gap < 2 * (degree - 1); ++gap)
+          {
+            length += topology.weights[gap] * gaps[gap];
+          }
+          if(length < bestLength)
+          {
+            bestLength = length;
+            best = &topology;
+          }
+        }
+
+        SteinerTree tree;
+        tree.points = pins;
+        for(unsigned point = 0; point < best->numSteinerPoints; ++point)
+        {
+          tree.points.emplace_back(pins[byX[best->steinerPoints[point].first]].first, pins[byY[best->steinerPoints[point].second]].second);
+        }
+        //nodes below degree are pins in x order
+        auto pointOf = [&](unsigned node) { return node < degree ? byX[node] : node; };
+        for(unsigned edge = 0; edge < best->numEdges; ++edge)
+        {
+          tree.edges.emplace_back(pointOf(best->edges[edge].first), pointOf(best->edges[edge].second));
+        }
+        return tree;
+      }
+  };
+
+  //Rectilinear minimum spanning tree (Prim, O(pins^2)) improved by Steiner points: for every point, the pair
+  //of its neighbours that saves most wirelength is connected through the median point of the three.
+  inline SteinerTree buildHeuristicSteinerTree(const std::vector<Location> & pins)
+  {
+    SteinerTree tree;
+    tree.points = pins;
+    const std::size_t numPins = pins.size();
+    if(numPins < 2)
+      return tree;
+
+    std::vector<std::uint64_t> distances(numPins, std::numeric_limits<std::uint64_t>::max());
+    std::vector<unsigned> closest(numPins, 0);
+    std::vector<char> inTree(numPins, 0);
+    unsigned current = 0;
+    inTree[0] = 1;
+    for(std::size_t step = 1; step < numPins; ++step)
+    {
+      unsigned next = 0;
+      std::uint64_t nextDistance = std::numeric_limits<std::uint64_t>::max();
+      for(unsigned pin = 0; pin < numPins; ++pin)
+      {
+        if(inTree[pin])
+          continue;
+        std::uint64_t distance = SteinerTree::distance(pins[pin], pins[current]);
+        if(distance < distances[pin])
+        {
+          distances[pin] = distance;
+          closest[pin] = current;
+        }
+        if(distances[pin] < nextDistance)
+        {
+          nextDistance = distances[pin];
+          next = pin;
+        }
+      }
+      inTree[next] = 1;
+      tree.edges.emplace_back(closest[next], next);
+      current = next;
+    }
+
+    std::vector<std::vector<unsigned>> neighbours(numPins);
+    for(auto & edge : tree.edges)
+    {
+      neighbours[edge.first].push_back(edge.second);
+      neighbours[edge.second].push_back(edge.first);
+    }
+    auto median = [](unsigned a, unsigned b, unsigned c) { return std::max(std::min(a, b), std::min(std::max(a, b), c)); };
+    for(unsigned point = 0; point < numPins; ++point)
+    {
+      auto & adjacent = neighbours[point];
+      std::uint64_t bestGain = 0;
+      std::size_t bestA = 0, bestB = 0;
+      Location bestMedian;
+      for(std::size_t a = 0; a < adjacent.size(); ++a)
+      {
+        for(std::size_t b = a + 1; b < adjacent.size(); ++b)
+        {
+          const Location & p = tree.points[point], & q = tree.points[adjacent[a]], & r = tree.points[adjacent[b]];
+          Location m{median(p.first, q.first, r.first), median(p.second, q.second, r.second)};
+          std::uint64_t gain = SteinerTree::distance(p, q) + SteinerTree::distance(p, r) -
+                               (SteinerTree::distance(p, m) + SteinerTree::distance(m, q) + SteinerTree::distance(m, r));
+          if(gain > bestGain)
+          {
+            bestGain = gain;
+            bestA = a;
+            bestB = b;
+            bestMedian = m;
+          }
+        }
+      }
+      if(bestGain == 0)
+        continue;
+
+      const unsigned steiner = tree.points.size();
+      const unsigned a = adjacent[bestA], b = adjacent[bestB];
+      adjacent.erase(adjacent.begin() + bestB);
+      adjacent[bestA] = steiner;
+      for(unsigned other : {a, b})
+      {
+        std::replace(neighbours[other].begin(), neighbours[other].end(), point, steiner);
+      }
+      tree.points.push_back(bestMedian);
+      neighbours.push_back({point, a, b});
+    }
+
+    tree.edges.clear();
+    for(unsigned point = 0; point < neighbours.size(); ++point)
+    {
+      for(auto neighbour : neighbours[point])
+      {
+        if(point < neighbour)
+          tree.edges.emplace_back(point, neighbour);
+      }
+    }
+    return tree;
+  }
+
+  //Steiner tree of a net: optimal (lookup table) up to SteinerLookupTable::MaxDegree pins, heuristic above
+  inline SteinerTree buildSteinerTree(const std::vector<Location> & pins)
+  {
+    if(pins.size() < 2 || pins.size() > SteinerLookupTable::MaxDegree)
+      return buildHeuristicSteinerTree(pins);
+    return SteinerLookupTable::instance().build(pins);
+  }
+
+  //Steiner trees of many nets, built in parallel
+  inline std::vector<SteinerTree> buildSteinerTrees(const std::vector<std::vector<Location>> & nets)
+  {
+    std::vector<SteinerTree> trees(nets.size());
+    //generates the lookup table before the threads use it
+    SteinerLookupTable::instance();
+    const std::ptrdiff_t size = nets.size();
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for(std::ptrdiff_t net = 0; net < size; ++net)
+    {
+      trees[net] = buildSteinerTree(nets[net]);
+    }
+    return trees;
+  }
+
+} //end of namespace common
+
+#endif //COMMON_STEINER_TREE_HPP
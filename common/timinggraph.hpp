@@ -0,0 +1,202 @@
+#ifndef COMMON_TIMING_GRAPH_HPP
+#define COMMON_TIMING_GRAPH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "utils.hpp"
+
+namespace common
+{
+  //timing arc between two timing points (cell arc or net arc)
+  struct TimingArc
+  {
+    unsigned from;
+    unsigned to;
+    double delay;
+  };
+
+  //net arc whose delay is given by the node `node` of the RC tree `tree` of the net parasitics
+  struct NetArcParasitics
+  {
+    unsigned from;
+    unsigned to;
+    unsigned tree;
+    unsigned node;
+  };
+
+  //timing path from a start point to an end point, timing points are given by id
+  struct TimingPath
+  {
+    double slack;
+    std::vector<unsigned> timingPoints;
+  };
+
+  //Topological order split in levels: the nodes of level l are
+  //nodes[levelOffsets[l], levelOffsets[l+1]) and depend only on nodes of previous levels
+  struct TopologicalOrder
+  {
+    std::vector<unsigned> nodes;
+    std::vector<std::size_t> levelOffsets;
+
+    std::size_t numLevels() const { return levelOffsets.size() - 1; }
+  };
+
+  //Compressed sparse row (CSR) timing graph. The nodes are the timing point ids
+  //and both fanins and fanouts are stored in flat arrays, so the propagation walks
+  //contiguous memory instead of chasing pointers.
+  class TimingGraph
+  {
+    std::vector<std::size_t> m_faninOffsets{0};
+    std::vector<unsigned> m_faninNodes;
+    std::vector<double> m_faninDelays;
+
+    std::vector<std::size_t> m_fanoutOffsets{0};
+    std::vector<unsigned> m_fanoutNodes;
+    std::vector<double> m_fanoutDelays;
+
+    //counting sort of the arcs by one of its end points
+    template <class Key, class Other>
+    static void buildCSR(std::size_t numNodes, const std::vector<TimingArc> & arcs, Key key, Other other,
+                         std::vector<std::size_t> & offsets, std::vector<unsigned> & nodes, std::vector<double> & delays)
+    {
+      offsets.assign(numNodes + 1, 0);
+      for(auto & arc : arcs)
+      {
+        ++offsets[key(arc) + 1];
+      }
+      for(std::size_t node = 0; node < numNodes; ++node)
+      {
+        offsets[node + 1] += offsets[node];
+      }
+
+      std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
+      nodes.resize(arcs.size());
+      delays.resize(arcs.size());
+      for(auto & arc : arcs)
+      {
+        auto position = next[key(arc)]++;
+        nodes[position] = other(arc);
+        delays[position] = arc.delay;
+      }
+    }
+
+    public:
+      TimingGraph() = default;
+
+      TimingGraph(std::size_t numNodes, const std::vector<TimingArc> & arcs)
+      {
+        for(auto & arc : arcs)
+        {
+          if(arc.from >= numNodes || arc.to >= numNodes)
+            throw std::out_of_range("Timing arc references an unknown timing point");
+        }
+
+        auto from = [](const TimingArc & arc) { return arc.from; };
+        auto to = [](const TimingArc & arc) { return arc.to; };
+        buildCSR(numNodes, arcs, to, from, m_faninOffsets, m_faninNodes, m_faninDelays);
+        buildCSR(numNodes, arcs, from, to, m_fanoutOffsets, m_fanoutNodes, m_fanoutDelays);
+      }
+
+      //graph given by its CSR arrays (e.g. mapped from a timing snapshot), the offsets have numNodes + 1 entries
+      TimingGraph(std::size_t numNodes, std::size_t numArcs,
+                  const std::uint64_t * faninOffsets, const std::uint32_t * faninNodes, const double * faninDelays,
+                  const std::uint64_t * fanoutOffsets, const std::uint32_t * fanoutNodes, const double * fanoutDelays) :
+        m_faninOffsets(faninOffsets, faninOffsets + numNodes + 1),
+        m_faninNodes(faninNodes, faninNodes + numArcs),
+        m_faninDelays(faninDelays, faninDelays + numArcs),
+        m_fanoutOffsets(fanoutOffsets, fanoutOffsets + numNodes + 1),
+        m_fanoutNodes(fanoutNodes, fanoutNodes + numArcs),
+        m_fanoutDelays(fanoutDelays, fanoutDelays + numArcs)
+      {
+        if(m_faninOffsets.back() != numArcs || m_fanoutOffsets.back() != numArcs)
+          throw std::out_of_range("Timing graph offsets do not match the number of arcs");
+      }
+
+      std::size_t numNodes() const { return m_faninOffsets.size() - 1; }
+      std::size_t numArcs() const { return m_faninNodes.size(); }
+
+      //fanins of node are the positions [faninBegin(node), faninEnd(node))
+      std::size_t faninBegin(unsigned node) const { return m_faninOffsets[node]; }
+      std::size_t faninEnd(unsigned node) const { return m_faninOffsets[node + 1]; }
+      unsigned faninNode(std::size_t position) const { return m_faninNodes[position]; }
+      double faninDelay(std::size_t position) const { return m_faninDelays[position]; }
+
+      //fanouts of node are the positions [fanoutBegin(node), fanoutEnd(node))
+      std::size_t fanoutBegin(unsigned node) const { return m_fanoutOffsets[node]; }
+      std::size_t fanoutEnd(unsigned node) const { return m_fanoutOffsets[node + 1]; }
+      unsigned fanoutNode(std::size_t position) const { return m_fanoutNodes[position]; }
+      double fanoutDelay(std::size_t position) const { return m_fanoutDelays[position]; }
+
+      //updates the delay of all arcs from -> to, keeping the fanin and fanout arrays consistent
+      void setArcDelay(unsigned from, unsigned to, double delay)
+      {
+        if(from >= numNodes() || to >= numNodes())
+          throw std::out_of_range("Timing arc references an unknown timing point");
+
+        bool found = false;
+        for(auto position = faninBegin(to); position < faninEnd(to); ++position)
+        {
+          if(m_faninNodes[position] == from)
+          {
+            m_faninDelays[position] = delay;
+            found = true;
+          }
+        }
+        for(auto position = fanoutBegin(from); position < fanoutEnd(from); ++position)
+        {
+          if(m_fanoutNodes[position] == to)
+            m_fanoutDelays[position] = delay;
+        }
+
+        if(!found)
+          throw std::out_of_range("Timing arc not found");
+      }
+
+      bool isStartPoint(unsigned node) const { return faninBegin(node) == faninEnd(node); }
+      bool isEndPoint(unsigned node) const { return fanoutBegin(node) == fanoutEnd(node); }
+
+      //Kahn's algorithm, O(nodes + arcs). Every node is placed in the level after its deepest fanin.
+      TopologicalOrder topologicalSort() const
+      {
+        TopologicalOrder order;
+        order.nodes.reserve(numNodes());
+        order.levelOffsets.push_back(0);
+
+        std::vector<std::size_t> pendingFanins(numNodes());
+        for(unsigned node = 0; node < numNodes(); ++node)
+        {
+          pendingFanins[node] = faninEnd(node) - faninBegin(node);
+          if(pendingFanins[node] == 0)
+            order.nodes.push_back(node);
+        }
+
+        std::size_t levelBegin = 0;
+        while(levelBegin < order.nodes.size())
+        {
+          std::size_t levelEnd = order.nodes.size();
+          order.levelOffsets.push_back(levelEnd);
+          for(std::size_t i = levelBegin; i < levelEnd; ++i)
+          {
+            unsigned node = order.nodes[i];
+            for(auto position = fanoutBegin(node); position < fanoutEnd(node); ++position)
+            {
+              if(--pendingFanins[fanoutNode(position)] == 0)
+                order.nodes.push_back(fanoutNode(position));
+            }
+          }
+          levelBegin = levelEnd;
+        }
+
+        if(order.nodes.size() != numNodes())
+          throw std::runtime_error("Timing graph has a combinational loop");
+
+        return order;
+      }
+  };
+
+} //end of namespace common
+
+#endif //COMMON_TIMING_GRAPH_HPP
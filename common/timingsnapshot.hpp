@@ -0,0 +1,268 @@
+#ifndef COMMON_TIMING_SNAPSHOT_HPP
+#define COMMON_TIMING_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/core/noncopyable.hpp>
+
+#include "timinggraph.hpp"
+#include "utils.hpp"
+
+//Binary snapshot of a sorted timing graph and its timing state. The file is mapped back with mmap and
+//queried in place (zero-copy), or restored into a timing analysis that continues with incremental STA.
+//Restoring copies the arrays out of the mapping into the analysis' own storage, but skips rebuilding
+//and re-sorting the graph.
+//The snapshot is meant to be read on the same platform it was written (native endianness and layout).
+
+namespace common
+{
+  struct TimingSnapshotHeader
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint64_t numTimingPoints;
+    std::uint64_t numArcs;
+    std::uint64_t numLevels;
+    double clockPeriod;
+  };
+
+  //timing state saved with the graph, enough to restart the incremental STA from the snapshot
+  struct TimingSnapshotState
+  {
+    //the values are up to date with the graph (no pending changes) for the late or the late/early scenario
+    bool timed;
+    bool earlyScenario;
+    double clockPeriod;
+    //indexed by timing point id
+    const std::vector<double> & lateArrivals;
+    const std::vector<double> & lateRequireds;
+    const std::vector<double> & lateSlacks;
+    const std::vector<double> & earlyArrivals;
+    const std::vector<double> & earlyRequireds;
+    const std::vector<double> & earlySlacks;
+  };
+
+  static_assert(std::is_trivially_copyable<TimingPoint>::value, "TimingPoint is stored as raw bytes in the snapshot");
+
+  //Offsets of the sections of the file, every section starts at a cache line boundary:
+  //sorted timing points, level offsets, fanin CSR, fanout CSR and the late and early timing values
+  struct TimingSnapshotLayout
+  {
+    static constexpr std::uint32_t Version = 2;
+    static constexpr std::uint64_t Alignment = 64;
+    //header flags
+    static constexpr std::uint32_t Timed = 1;
+    static constexpr std::uint32_t EarlyScenario = 2;
+
+    std::uint64_t timingPoints, levelOffsets;
+    std::uint64_t faninOffsets, faninNodes, faninDelays;
+    std::uint64_t fanoutOffsets, fanoutNodes, fanoutDelays;
+    std::uint64_t lateArrivals, lateRequireds, lateSlacks;
+    std::uint64_t earlyArrivals, earlyRequireds, earlySlacks;
+    std::uint64_t size;
+
+    static const char * magic() { return "PSDPSTA"; }
+
+    TimingSnapshotLayout() = default;
+
+    explicit TimingSnapshotLayout(const TimingSnapshotHeader & header)
+    {
+      std::uint64_t offset = sizeof(TimingSnapshotHeader);
+      auto section = [&offset](std::uint64_t bytes)
+      {
+        std::uint64_t begin = (offset + Alignment - 1) / Alignment * Alignment;
+        offset = begin + bytes;
+        return begin;
+      };
+
+      const std::uint64_t nodes = header.numTimingPoints;
+      const std::uint64_t arcs = header.numArcs;
+      timingPoints = section(nodes * sizeof(TimingPoint));
+      levelOffsets = section((header.numLevels + 1) * sizeof(std::uint64_t));
+      faninOffsets = section((nodes + 1) * sizeof(std::uint64_t));
+      faninNodes = section(arcs * sizeof(std::uint32_t));
+      faninDelays = section(arcs * sizeof(double));
+      fanoutOffsets = section((nodes + 1) * sizeof(std::uint64_t));
+      fanoutNodes = section(arcs * sizeof(std::uint32_t));
+      fanoutDelays = section(arcs * sizeof(double));
+      lateArrivals = section(nodes * sizeof(double));
+      lateRequireds = section(nodes * sizeof(double));
+      lateSlacks = section(nodes * sizeof(double));
+      earlyArrivals = section(nodes * sizeof(double));
+      earlyRequireds = section(nodes * sizeof(double));
+      earlySlacks = section(nodes * sizeof(double));
+      size = offset;
+    }
+  };
+
+  inline void writeTimingSnapshot(const std::string & file,
+                                  const std::vector<TimingPoint> & topologicalSortedTPs,
+                                  const std::vector<std::size_t> & levelOffsets,
+                                  const TimingGraph & graph,
+                                  const TimingSnapshotState & state)
+  {
+    TimingSnapshotHeader header;
+    std::memcpy(header.magic, TimingSnapshotLayout::magic(), sizeof(header.magic));
+    header.version = TimingSnapshotLayout::Version;
+    header.flags = (state.timed ? TimingSnapshotLayout::Timed : 0) | (state.earlyScenario ? TimingSnapshotLayout::EarlyScenario : 0);
+    header.numTimingPoints = topologicalSortedTPs.size();
+    header.numArcs = graph.numArcs();
+    header.numLevels = levelOffsets.size() - 1;
+    header.clockPeriod = state.clockPeriod;
+    TimingSnapshotLayout layout(header);
+
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    if(!out)
+      throw std::runtime_error("Could not open the timing snapshot for writing: " + file);
+
+    auto seek = [&out](std::uint64_t offset)
+    {
+      static const char padding[TimingSnapshotLayout::Alignment] = {};
+      out.write(padding, offset - out.tellp());
+    };
+    auto write = [&out](auto value)
+    {
+      out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    };
+
+    write(header);
+    seek(layout.timingPoints);
+    out.write(reinterpret_cast<const char *>(topologicalSortedTPs.data()), topologicalSortedTPs.size() * sizeof(TimingPoint));
+    seek(layout.levelOffsets);
+    for(auto offset : levelOffsets) write(std::uint64_t(offset));
+
+    seek(layout.faninOffsets);
+    for(unsigned node = 0; node <= graph.numNodes(); ++node) write(std::uint64_t(node < graph.numNodes() ? graph.faninBegin(node) : graph.numArcs()));
+    seek(layout.faninNodes);
+    for(std::size_t position = 0; position < graph.numArcs(); ++position) write(std::uint32_t(graph.faninNode(position)));
+    seek(layout.faninDelays);
+    for(std::size_t position = 0; position < graph.numArcs(); ++position) write(graph.faninDelay(position));
+
+    seek(layout.fanoutOffsets);
+    for(unsigned node = 0; node <= graph.numNodes(); ++node) write(std::uint64_t(node < graph.numNodes() ? graph.fanoutBegin(node) : graph.numArcs()));
+    seek(layout.fanoutNodes);
+    for(std::size_t position = 0; position < graph.numArcs(); ++position) write(std::uint32_t(graph.fanoutNode(position)));
+    seek(layout.fanoutDelays);
+    for(std::size_t position = 0; position < graph.numArcs(); ++position) write(graph.fanoutDelay(position));
+
+    auto writeValues = [&](std::uint64_t offset, const std::vector<double> & values)
+    {
+      seek(offset);
+      out.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(double));
+    };
+    writeValues(layout.lateArrivals, state.lateArrivals);
+    writeValues(layout.lateRequireds, state.lateRequireds);
+    writeValues(layout.lateSlacks, state.lateSlacks);
+    writeValues(layout.earlyArrivals, state.earlyArrivals);
+    writeValues(layout.earlyRequireds, state.earlyRequireds);
+    writeValues(layout.earlySlacks, state.earlySlacks);
+
+    if(!out)
+      throw std::runtime_error("Could not write the timing snapshot: " + file);
+  }
+
+  //Read-only zero-copy view of a timing snapshot mapped in memory, see structural::TimingAnalysisImplementation to restore it
+  class TimingSnapshot : public boost::noncopyable
+  {
+    const char * m_data = nullptr;
+    std::size_t m_size = 0;
+    TimingSnapshotHeader m_header;
+    TimingSnapshotLayout m_layout;
+
+    template <class T>
+    const T * section(std::uint64_t offset) const { return reinterpret_cast<const T *>(m_data + offset); }
+
+    public:
+      explicit TimingSnapshot(const std::string & file)
+      {
+        int descriptor = ::open(file.c_str(), O_RDONLY);
+        if(descriptor < 0)
+          throw std::runtime_error("Could not open the timing snapshot: " + file);
+
+        struct stat status;
+        if(::fstat(descriptor, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(TimingSnapshotHeader))
+        {
+          ::close(descriptor);
+          throw std::runtime_error("Invalid timing snapshot: " + file);
+        }
+
+        m_size = status.st_size;
+        void * data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, descriptor, 0);
+        ::close(descriptor);
+        if(data == MAP_FAILED)
+          throw std::runtime_error("Could not map the timing snapshot: " + file);
+        m_data = static_cast<const char *>(data);
+
+        std::memcpy(&m_header, m_data, sizeof(m_header));
+        if(std::memcmp(m_header.magic, TimingSnapshotLayout::magic(), sizeof(m_header.magic)) != 0 ||
+           m_header.version != TimingSnapshotLayout::Version ||
+           TimingSnapshotLayout(m_header).size != m_size)
+        {
+          ::munmap(const_cast<char *>(m_data), m_size);
+          throw std::runtime_error("Invalid or incompatible timing snapshot: " + file);
+        }
+        m_layout = TimingSnapshotLayout(m_header);
+      }
+
+      ~TimingSnapshot()
+      {
+        ::munmap(const_cast<char *>(m_data), m_size);
+      }
+
+      std::size_t numTimingPoints() const { return m_header.numTimingPoints; }
+      std::size_t numArcs() const { return m_header.numArcs; }
+      std::size_t numLevels() const { return m_header.numLevels; }
+      double clockPeriod() const { return m_header.clockPeriod; }
+      bool timed() const { return m_header.flags & TimingSnapshotLayout::Timed; }
+      bool earlyScenario() const { return m_header.flags & TimingSnapshotLayout::EarlyScenario; }
+
+      //timing points in topological order, level l is [levelOffsets()[l], levelOffsets()[l+1])
+      const TimingPoint * topologicalSortedTPs() const { return section<TimingPoint>(m_layout.timingPoints); }
+      const std::uint64_t * levelOffsets() const { return section<std::uint64_t>(m_layout.levelOffsets); }
+
+      //CSR arrays, as in TimingGraph
+      const std::uint64_t * faninOffsets() const { return section<std::uint64_t>(m_layout.faninOffsets); }
+      const std::uint32_t * faninNodes() const { return section<std::uint32_t>(m_layout.faninNodes); }
+      const double * faninDelays() const { return section<double>(m_layout.faninDelays); }
+      const std::uint64_t * fanoutOffsets() const { return section<std::uint64_t>(m_layout.fanoutOffsets); }
+      const std::uint32_t * fanoutNodes() const { return section<std::uint32_t>(m_layout.fanoutNodes); }
+      const double * fanoutDelays() const { return section<double>(m_layout.fanoutDelays); }
+
+      //timing values indexed by timing point id
+      const double * lateArrivals() const { return section<double>(m_layout.lateArrivals); }
+      const double * lateRequireds() const { return section<double>(m_layout.lateRequireds); }
+      const double * lateSlacks() const { return section<double>(m_layout.lateSlacks); }
+      const double * earlyArrivals() const { return section<double>(m_layout.earlyArrivals); }
+      const double * earlyRequireds() const { return section<double>(m_layout.earlyRequireds); }
+      const double * earlySlacks() const { return section<double>(m_layout.earlySlacks); }
+
+      double lateSlack(const TimingPoint & timingPoint) const
+      {
+        if(timingPoint.id >= numTimingPoints())
+          throw std::out_of_range("Unknown timing point");
+        return lateSlacks()[timingPoint.id];
+      }
+
+      double earlySlack(const TimingPoint & timingPoint) const
+      {
+        if(timingPoint.id >= numTimingPoints())
+          throw std::out_of_range("Unknown timing point");
+        return earlySlacks()[timingPoint.id];
+      }
+  };
+
+} //end of namespace common
+
+#endif //COMMON_TIMING_SNAPSHOT_HPP
@@ -1,16 +1,26 @@
 #ifndef COMMON_UTILS_HPP
 #define COMMON_UTILS_HPP
 
+#include <cstdint>
 #include <ostream>
+#include <vector>
+
+#include <boost/align/aligned_allocator.hpp>
 
 namespace common
 {
+  //vector whose data is aligned to a cache line, for vectorized loops
+  template <class T>
+  using AlignedVector = std::vector<T, boost::alignment::aligned_allocator<T, 64>>;
+
   //width,height
   using Shape    = std::pair<unsigned, unsigned>;
   //x,y
   using Location = std::pair<unsigned, unsigned>;
   //rise,fall
   using TimingInfo = std::pair<double, double>;
+  //lower left, upper right
+  using BoundingBox = std::pair<Location, Location>;
   
   enum class LogicFunction {INV, NAND2, NOR2};
 
@@ -18,6 +28,10 @@ namespace common
   {
     std::string name;
     unsigned num_pins;
+    BoundingBox bbox;
+    //GCells of the pins (lowest layer) and GCell grid edges of the route
+    std::vector<Location> pins;
+    std::vector<std::uint32_t> route;
   };
 
   struct TimingPoint
@@ -27,6 +41,14 @@ namespace common
     double slack;
   };
 
+  //PVT corner (delay scaling) and mode (clock period) analysed by multi-corner STA
+  struct TimingCorner
+  {
+    std::string name;
+    double delayScale;
+    double clockPeriod;
+  };
+
   struct Pin
   {
     unsigned id;
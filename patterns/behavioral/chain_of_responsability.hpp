@@ -1,8 +1,24 @@
 #ifndef PATTERNS_BEHAVIORAL_CHAIN_OF_RESPONSABILITY_HPP
 #define PATTERNS_BEHAVIORAL_CHAIN_OF_RESPONSABILITY_HPP
  
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <common/congestionmap.hpp>
+#include <common/mazerouter.hpp>
+#include <common/patternroute.hpp>
+#include <common/routeselection.hpp>
+#include <common/steinertree.hpp>
 #include <common/utils.hpp>
 
 namespace behavioral
@@ -10,20 +26,279 @@ namespace behavioral
 
 //Different optimizations in a chain build by the user?
 
+using NetBatch = std::vector<common::Net *>;
+
+//routing telemetry of a handler
+struct RoutingStatistics
+{
+  static constexpr unsigned NumLatencyBins = 24;
+
+  std::string handler;
+  std::uint64_t attempts = 0;
+  std::uint64_t successes = 0;
+  //nets sent straight to the next handler by the adaptive mode
+  std::uint64_t skipped = 0;
+  double seconds = 0.0;
+  //bin b counts the attempts that took [2^b, 2^(b+1)) microseconds, bin 0 also counts the faster ones
+  std::array<std::uint64_t, NumLatencyBins> latencyHistogram{};
+
+  double successRate() const { return attempts ? double(successes) / attempts : 0.0; }
+};
+
 class RipUpAndReRouteHandler
 {
+  //batches (waves) smaller than this are routed serially, the threading overhead does not pay off
+  static constexpr std::ptrdiff_t MinParallelWaveSize = 64;
+  //bins per side of the grid used to find nets with disjoint bounding boxes
+  static constexpr std::uint64_t NumBinsPerSide = 256;
+  //the waves are tracked with a 64 bits mask per bin, the last one is routed serially
+  static constexpr unsigned MaxNumWaves = 64;
+
+  //the adaptive mode classifies the nets by pin count and bounding box half perimeter
+  static constexpr unsigned NumPinClasses = 5;
+  static constexpr unsigned NumSizeClasses = 8;
+  static constexpr unsigned NumFeatureClasses = NumPinClasses * NumSizeClasses;
+  //a class is skipped only after this many attempts, and one out of ExplorationPeriod of its nets is still attempted
+  static constexpr std::uint64_t MinAdaptiveAttempts = 32;
+  static constexpr std::uint64_t ExplorationPeriod = 16;
+
   std::shared_ptr<RipUpAndReRouteHandler> m_parent;
+  //routing resources shared by all the handlers of the chain (and all their threads)
+  std::shared_ptr<common::CongestionMap> m_congestionMap;
+
+  //telemetry, updated concurrently by the routing threads
+  std::atomic<std::uint64_t> m_attempts{0};
+  std::atomic<std::uint64_t> m_successes{0};
+  std::atomic<std::uint64_t> m_skipped{0};
+  std::atomic<std::uint64_t> m_nanoseconds{0};
+  std::array<std::atomic<std::uint64_t>, RoutingStatistics::NumLatencyBins> m_latencyHistogram{};
+  std::array<std::atomic<std::uint64_t>, NumFeatureClasses> m_classAttempts{};
+  std::array<std::atomic<std::uint64_t>, NumFeatureClasses> m_classSuccesses{};
+  std::array<std::atomic<std::uint64_t>, NumFeatureClasses> m_classSkips{};
+
+  bool m_adaptive = false;
+  double m_minSuccessRate = 0.0;
+
+  static unsigned featureClass(const common::Net & net)
+  {
+    std::size_t pins = net.pins.empty() ? net.num_pins : net.pins.size();
+    unsigned pinClass = pins <= 2 ? 0 : pins == 3 ? 1 : pins <= 5 ? 2 : pins <= 9 ? 3 : 4;
+    std::uint64_t halfPerimeter = std::uint64_t(net.bbox.second.first - net.bbox.first.first) + (net.bbox.second.second - net.bbox.first.second);
+    unsigned sizeClass = 0;
+    while(sizeClass + 1 < NumSizeClasses && halfPerimeter >> (sizeClass + 1) > 0)
+    {
+      ++sizeClass;
+    }
+    return pinClass * NumSizeClasses + sizeClass;
+  }
+
+  //Splits the nets in waves whose bounding boxes do not overlap, so the nets of a wave can be
+  //routed concurrently. The bounding boxes are rasterized in a coarse grid of bins and every bin keeps
+  //the mask of the waves using it, a net goes to the first wave not using any of its bins.
+  static std::vector<NetBatch> splitInWaves(const NetBatch & nets)
+  {
+    std::vector<NetBatch> waves;
+    if(nets.empty())
+      return waves;
+
+    common::Location lower = nets.front()->bbox.first;
+    common::Location upper = nets.front()->bbox.second;
+    for(auto net : nets)
+    {
+      lower.first = std::min(lower.first, net->bbox.first.first);
+      lower.second = std::min(lower.second, net->bbox.first.second);
+      upper.first = std::max(upper.first, net->bbox.second.first);
+      upper.second = std::max(upper.second, net->bbox.second.second);
+    }
+    const std::uint64_t binWidth = (std::uint64_t(upper.first) - lower.first) / NumBinsPerSide + 1;
+    const std::uint64_t binHeight = (std::uint64_t(upper.second) - lower.second) / NumBinsPerSide + 1;
+    std::vector<std::uint64_t> binWaves(NumBinsPerSide * NumBinsPerSide, 0);
+
+    waves.resize(MaxNumWaves);
+    for(auto net : nets)
+    {
+      const std::uint64_t xBegin = (net->bbox.first.first - lower.first) / binWidth;
+      const std::uint64_t xEnd = (net->bbox.second.first - lower.first) / binWidth;
+      const std::uint64_t yBegin = (net->bbox.first.second - lower.second) / binHeight;
+      const std::uint64_t yEnd = (net->bbox.second.second - lower.second) / binHeight;
+
+      std::uint64_t used = 0;
+      for(auto x = xBegin; x <= xEnd; ++x)
+        for(auto y = yBegin; y <= yEnd; ++y)
+          used |= binWaves[x * NumBinsPerSide + y];
+
+      unsigned wave = 0;
+      while(wave < MaxNumWaves - 1 && (used >> wave) & 1)
+      {
+        ++wave;
+      }
+      waves[wave].push_back(net);
+
+      for(auto x = xBegin; x <= xEnd; ++x)
+        for(auto y = yBegin; y <= yEnd; ++y)
+          binWaves[x * NumBinsPerSide + y] |= std::uint64_t(1) << wave;
+    }
+
+    waves.erase(std::remove_if(waves.begin(), waves.end(), [](const NetBatch & wave) { return wave.empty(); }), waves.end());
+    return waves;
+  }
 
   protected:
     virtual bool routeNet(common::Net & net) = 0;
 
+    //Calls routeNet() recording the telemetry. In adaptive mode, nets of a class this handler rarely
+    //routes are not attempted (but for a few exploration attempts) and are reported as not routed.
+    bool attemptRoute(common::Net & net)
+    {
+      const unsigned netClass = featureClass(net);
+      if(m_adaptive && m_parent)
+      {
+        std::uint64_t attempts = m_classAttempts[netClass].load(std::memory_order_relaxed);
+        std::uint64_t successes = m_classSuccesses[netClass].load(std::memory_order_relaxed);
+        if(attempts >= MinAdaptiveAttempts && successes < m_minSuccessRate * attempts &&
+           m_classSkips[netClass].fetch_add(1, std::memory_order_relaxed) % ExplorationPeriod != 0)
+        {
+          m_skipped.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        }
+      }
+
+      //rerouting a net rips up its current route first, so its old usage is not left in the congestion map
+      if(m_congestionMap)
+      {
+        m_congestionMap->removeRoute(net.route);
+        net.route.clear();
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      bool routed = routeNet(net);
+      recordAttempt(net, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), routed);
+      return routed;
+    }
+
+    //telemetry of a routing attempt made without attemptRoute()
+    void recordAttempt(const common::Net & net, std::uint64_t nanoseconds, bool routed)
+    {
+      const unsigned netClass = featureClass(net);
+      unsigned bin = 0;
+      for(std::uint64_t microseconds = nanoseconds / 1000; microseconds > 1 && bin + 1 < RoutingStatistics::NumLatencyBins; microseconds >>= 1)
+      {
+        ++bin;
+      }
+      m_latencyHistogram[bin].fetch_add(1, std::memory_order_relaxed);
+      m_nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+      m_attempts.fetch_add(1, std::memory_order_relaxed);
+      m_classAttempts[netClass].fetch_add(1, std::memory_order_relaxed);
+      if(routed)
+      {
+        m_successes.fetch_add(1, std::memory_order_relaxed);
+        m_classSuccesses[netClass].fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    common::CongestionMap * congestionMap() const { return m_congestionMap.get(); }
+
+    //Routes the nets wave by wave, the nets that could not be routed are escalated together to the parent
+    void routeBatch(const NetBatch & nets)
+    {
+      std::vector<char> routed(nets.size(), 0);
+      NetBatch failed;
+
+      //the waves are routed concurrently, so the batch is reported here and not net by net
+      auto waves = splitInWaves(nets);
+      std::cout << name() << " trying to route " << nets.size() << " nets in " << waves.size() << " waves" << std::endl;
+      std::size_t first = 0;
+      for(std::size_t index = 0; index < waves.size(); ++index)
+      {
+        const NetBatch & wave = waves[index];
+        //the last wave of a full split may have overlapping bounding boxes
+        const bool concurrent = index + 1 < MaxNumWaves;
+        const std::ptrdiff_t size = wave.size();
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic, 16) if(concurrent && size >= MinParallelWaveSize)
+#endif
+        for(std::ptrdiff_t i = 0; i < size; ++i)
+        {
+          routed[first + i] = attemptRoute(*wave[i]);
+        }
+        for(std::ptrdiff_t i = 0; i < size; ++i)
+        {
+          if(!routed[first + i])
+            failed.push_back(wave[i]);
+        }
+        first += size;
+      }
+
+      if(!failed.empty())
+      {
+        std::cout << failed.size() << " Nets Not routed" << std::endl;
+        RipUpAndReRouteHandler::handleRouteRequests(failed);
+      }
+    }
+
   public:
-    RipUpAndReRouteHandler(std::shared_ptr<RipUpAndReRouteHandler> parent = nullptr) : m_parent(parent)
+    RipUpAndReRouteHandler(std::shared_ptr<RipUpAndReRouteHandler> parent = nullptr, std::shared_ptr<common::CongestionMap> congestionMap = nullptr) :
+      m_parent(parent), m_congestionMap(congestionMap)
     {
     }
     virtual ~RipUpAndReRouteHandler() 
     {
     }
+
+    virtual std::string name() const = 0;
+
+    RoutingStatistics statistics() const
+    {
+      RoutingStatistics statistics;
+      statistics.handler = name();
+      statistics.attempts = m_attempts.load(std::memory_order_relaxed);
+      statistics.successes = m_successes.load(std::memory_order_relaxed);
+      statistics.skipped = m_skipped.load(std::memory_order_relaxed);
+      statistics.seconds = m_nanoseconds.load(std::memory_order_relaxed) * 1e-9;
+      for(unsigned bin = 0; bin < RoutingStatistics::NumLatencyBins; ++bin)
+      {
+        statistics.latencyHistogram[bin] = m_latencyHistogram[bin].load(std::memory_order_relaxed);
+      }
+      return statistics;
+    }
+
+    //statistics of this handler and of the ones after it in the chain
+    std::vector<RoutingStatistics> chainStatistics() const
+    {
+      std::vector<RoutingStatistics> statistics{this->statistics()};
+      for(auto handler = m_parent.get(); handler; handler = handler->m_parent.get())
+      {
+        statistics.push_back(handler->statistics());
+      }
+      return statistics;
+    }
+
+    //clears the telemetry of the whole chain, including what the adaptive mode learnt
+    void resetStatistics()
+    {
+      for(auto handler = this; handler; handler = handler->m_parent.get())
+      {
+        handler->m_attempts = 0;
+        handler->m_successes = 0;
+        handler->m_skipped = 0;
+        handler->m_nanoseconds = 0;
+        for(auto & counter : handler->m_latencyHistogram) counter = 0;
+        for(auto & counter : handler->m_classAttempts) counter = 0;
+        for(auto & counter : handler->m_classSuccesses) counter = 0;
+        for(auto & counter : handler->m_classSkips) counter = 0;
+      }
+    }
+
+    //In adaptive mode a handler sends straight to the next one the nets of the classes (pin count and
+    //bounding box size) it routes less than minSuccessRate of the time. Applies to the whole chain.
+    void setAdaptive(bool adaptive, double minSuccessRate = 0.05)
+    {
+      for(auto handler = this; handler; handler = handler->m_parent.get())
+      {
+        handler->m_adaptive = adaptive;
+        handler->m_minSuccessRate = minSuccessRate;
+      }
+    }
    
     virtual void handleRouteRequest(common::Net & net)
     {
@@ -32,6 +307,26 @@ class RipUpAndReRouteHandler
         m_parent->handleRouteRequest(net);
       }
     }
+
+    //Called at the start of a routing run (e.g. by the negotiated congestion router), the handlers drop
+    //the state they keep about the nets of the previous run
+    virtual void startRun()
+    {
+      if(m_parent)
+      {
+        m_parent->startRun();
+      }
+    }
+
+    //Batch version of handleRouteRequest(): nets with disjoint bounding boxes are routed concurrently
+    //and only the nets that fail are escalated, as a batch, to the next handler of the chain
+    virtual void handleRouteRequests(const NetBatch & nets)
+    {
+      if(m_parent)
+      {
+        m_parent->handleRouteRequests(nets);
+      }
+    }
 };
 
 class FastGreedyRipUpAndReRoute : public RipUpAndReRouteHandler
@@ -39,14 +334,48 @@ class FastGreedyRipUpAndReRoute : public RipUpAndReRouteHandler
   protected:
     bool routeNet(common::Net & net) override
     {
-      std::cout << "GreedyRipUpAndReRoute trying to route net: " << net.name << std::endl;
+      //without routing resources only the pin count is checked
+      if(!congestionMap())
+        return net.num_pins < 4;
+
+      //every edge of the Steiner tree takes the first L shape (lowest layers first) with free capacity
+      common::CongestionMap & map = *congestionMap();
+      const common::GCellGrid & grid = map.grid();
+      const common::SteinerTree tree = common::buildSteinerTree(net.pins);
+      std::vector<std::uint32_t> route, segment;
+      for(auto & edge : tree.edges)
+      {
+        bool placed = false;
+        for(auto & layers : common::lShapeLayers(grid))
+        {
+          for(bool horizontalFirst : {true, false})
+          {
+            segment.clear();
+            common::appendLShape(grid, tree.points[edge.first], tree.points[edge.second], layers.first, layers.second, horizontalFirst, segment);
+            placed = std::all_of(segment.begin(), segment.end(), [&](std::uint32_t gridEdge)
+            {
+              return grid.edgeExists(gridEdge) && (map.available(gridEdge) || std::find(route.begin(), route.end(), gridEdge) != route.end());
+            });
+            if(placed)
+              break;
+          }
+          if(placed)
+            break;
+        }
+        if(!placed)
+          return false;
+        route.insert(route.end(), segment.begin(), segment.end());
+      }
 
-      //here goes the code to route the net
-      return net.num_pins < 4;
+      common::removeDuplicatedEdges(route);
+      net.route = route;
+      map.addRoute(net.route);
+      return true;
     }
 
   public:
-    FastGreedyRipUpAndReRoute(std::shared_ptr<RipUpAndReRouteHandler> parent = nullptr) : RipUpAndReRouteHandler(parent)
+    FastGreedyRipUpAndReRoute(std::shared_ptr<RipUpAndReRouteHandler> parent = nullptr, std::shared_ptr<common::CongestionMap> congestionMap = nullptr) :
+      RipUpAndReRouteHandler(parent, congestionMap)
     {
       std::cout << "Constructing GreedyRipUpAndReRoute" << std::endl;
     }
@@ -58,12 +387,23 @@ class FastGreedyRipUpAndReRoute : public RipUpAndReRouteHandler
 
     void handleRouteRequest(common::Net & net) override
     {
-      if(!routeNet(net))
+      std::cout << "GreedyRipUpAndReRoute trying to route net: " << net.name << std::endl;
+      if(!attemptRoute(net))
       {
         std::cout << "Net Not routed" << std::endl;
         RipUpAndReRouteHandler::handleRouteRequest(net);
       }
     }
+
+    void handleRouteRequests(const NetBatch & nets) override
+    {
+      routeBatch(nets);
+    }
+
+    std::string name() const override
+    {
+      return "FastGreedyRipUpAndReRoute";
+    }
 };
 
 class AStarRipUpAndReRoute : public RipUpAndReRouteHandler
@@ -71,14 +411,18 @@ class AStarRipUpAndReRoute : public RipUpAndReRouteHandler
   protected:
     bool routeNet(common::Net & net) override
     {
-      std::cout << "AStarRipUpAndReRoute trying to route net: " << net.name << std::endl;
+      //without routing resources only the pin count is checked
+      if(!congestionMap())
+        return net.num_pins < 6;
 
-      //here goes the code to route the net
-      return net.num_pins < 6;
+      //search buffers are allocated once per thread and reused by all its nets
+      static thread_local common::MazeRouteScratch scratch;
+      return common::MazeRouter(*congestionMap()).route(net, scratch);
     }
 
   public:
-    AStarRipUpAndReRoute(std::shared_ptr<RipUpAndReRouteHandler> parent = nullptr) : RipUpAndReRouteHandler(parent)
+    AStarRipUpAndReRoute(std::shared_ptr<RipUpAndReRouteHandler> parent = nullptr, std::shared_ptr<common::CongestionMap> congestionMap = nullptr) :
+      RipUpAndReRouteHandler(parent, congestionMap)
     {
       std::cout << "Constructing AStarRipUpAndReRoute" << std::endl;
     }
@@ -89,27 +433,189 @@ class AStarRipUpAndReRoute : public RipUpAndReRouteHandler
 
     void handleRouteRequest(common::Net & net) override
     {
-      if(!routeNet(net))
+      std::cout << "AStarRipUpAndReRoute trying to route net: " << net.name << std::endl;
+      if(!attemptRoute(net))
       {
         std::cout << "Net Not routed" << std::endl;
         RipUpAndReRouteHandler::handleRouteRequest(net);
       }
     }
+
+    void handleRouteRequests(const NetBatch & nets) override
+    {
+      routeBatch(nets);
+    }
+
+    std::string name() const override
+    {
+      return "AStarRipUpAndReRoute";
+    }
 };
 
 class ILPRipUpAndReRoute : public RipUpAndReRouteHandler
 {
+  //clusters larger than this are split, the branch and bound grows exponentially with the cluster size
+  static constexpr std::size_t MaxClusterSize = 16;
+  //cost of routing one net over the capacity of an edge, in units of wire cost
+  static constexpr std::uint64_t OverflowPenalty = 1000;
+
+  std::shared_ptr<common::RouteSelectionSolver> m_solver = std::make_shared<common::BranchAndBoundRouteSelectionSolver>();
+  std::chrono::steady_clock::duration m_clusterTimeBudget = std::chrono::milliseconds(10);
+  //candidate picked for each net the last time it was routed in the current run, used to warm start the solver
+  std::unordered_map<const common::Net *, unsigned> m_previousChoices;
+
+  //Candidate routes of a net: the edges of its Steiner tree routed as L shapes with the same pattern,
+  //one candidate for every pair of adjacent layers and orientation.
+  std::vector<std::vector<std::uint32_t>> candidateRoutes(const common::Net & net) const
+  {
+    const common::GCellGrid & grid = congestionMap()->grid();
+    const common::SteinerTree tree = common::buildSteinerTree(net.pins);
+    const bool vertical = std::any_of(tree.edges.begin(), tree.edges.end(), [&](const std::pair<unsigned, unsigned> & edge)
+    {
+      return tree.points[edge.first].second != tree.points[edge.second].second;
+    });
+
+    std::vector<std::vector<std::uint32_t>> routes;
+    for(auto & layers : common::lShapeLayers(grid))
+    {
+      if(vertical && layers.second >= grid.numLayers())
+        continue;
+      for(bool horizontalFirst : {true, false})
+      {
+        std::vector<std::uint32_t> route;
+        for(auto & edge : tree.edges)
+        {
+          common::appendLShape(grid, tree.points[edge.first], tree.points[edge.second], layers.first, layers.second, horizontalFirst, route);
+        }
+        common::removeDuplicatedEdges(route);
+        routes.push_back(std::move(route));
+      }
+    }
+    std::sort(routes.begin(), routes.end());
+    routes.erase(std::unique(routes.begin(), routes.end()), routes.end());
+    return routes;
+  }
+
+  //Groups the nets whose bounding boxes overlap (sweep along x and union-find) and splits the groups
+  //larger than MaxClusterSize.
+  static std::vector<NetBatch> clusters(const NetBatch & nets)
+  {
+    NetBatch sorted(nets);
+    std::sort(sorted.begin(), sorted.end(), [](const common::Net * a, const common::Net * b) { return a->bbox.first.first < b->bbox.first.first; });
+    std::vector<std::size_t> parents(sorted.size());
+    std::iota(parents.begin(), parents.end(), 0);
+    std::function<std::size_t(std::size_t)> find = [&](std::size_t net) { return parents[net] == net ? net : parents[net] = find(parents[net]); };
+
+    for(std::size_t i = 0; i < sorted.size(); ++i)
+    {
+      for(std::size_t j = i + 1; j < sorted.size() && sorted[j]->bbox.first.first <= sorted[i]->bbox.second.first; ++j)
+      {
+        if(sorted[i]->bbox.first.second <= sorted[j]->bbox.second.second && sorted[j]->bbox.first.second <= sorted[i]->bbox.second.second)
+          parents[find(i)] = find(j);
+      }
+    }
+
+    std::vector<NetBatch> groups(sorted.size());
+    for(std::size_t net = 0; net < sorted.size(); ++net)
+    {
+      groups[find(net)].push_back(sorted[net]);
+    }
+    std::vector<NetBatch> result;
+    for(auto & group : groups)
+    {
+      for(std::size_t begin = 0; begin < group.size(); begin += MaxClusterSize)
+      {
+        result.emplace_back(group.begin() + begin, group.begin() + std::min(group.size(), begin + MaxClusterSize));
+      }
+    }
+    return result;
+  }
+
+  //Picks a candidate route for every net of the cluster solving the route selection ILP and commits them.
+  //The nets without any candidate are returned.
+  NetBatch routeCluster(const NetBatch & cluster)
+  {
+    common::CongestionMap & map = *congestionMap();
+    NetBatch failed;
+    NetBatch selected;
+    std::vector<std::vector<std::vector<std::uint32_t>>> routes;
+    for(auto net : cluster)
+    {
+      map.removeRoute(net->route);
+      net->route.clear();
+      if(net->pins.size() < 2)
+        continue;
+      auto candidates = candidateRoutes(*net);
+      if(candidates.empty())
+      {
+        failed.push_back(net);
+        continue;
+      }
+      selected.push_back(net);
+      routes.push_back(std::move(candidates));
+    }
+    if(selected.empty())
+      return failed;
+
+    //the ILP only sees the edges used by some candidate, indexed in edges
+    std::vector<std::uint32_t> edges;
+    for(auto & candidates : routes)
+      for(auto & route : candidates)
+        edges.insert(edges.end(), route.begin(), route.end());
+    common::removeDuplicatedEdges(edges);
+
+    common::RouteSelectionProblem problem;
+    problem.overflowPenalty = OverflowPenalty;
+    problem.freeCapacities.resize(edges.size());
+    for(std::size_t edge = 0; edge < edges.size(); ++edge)
+    {
+      std::uint32_t capacity = map.capacity(edges[edge]), usage = map.usage(edges[edge]);
+      problem.freeCapacities[edge] = capacity > usage ? capacity - usage : 0;
+    }
+    std::vector<unsigned> warmStart;
+    for(std::size_t net = 0; net < selected.size(); ++net)
+    {
+      problem.candidates.emplace_back();
+      for(auto & route : routes[net])
+      {
+        common::RouteCandidate candidate{{}, 0};
+        for(auto edge : route)
+        {
+          candidate.edges.push_back(std::lower_bound(edges.begin(), edges.end(), edge) - edges.begin());
+          candidate.cost += (map.grid().edgeDirection(edge) == common::GCellDirection::UP ? common::MazeRouter::ViaCost : common::MazeRouter::WireCost) + map.historyCost(edge);
+        }
+        problem.candidates.back().push_back(std::move(candidate));
+      }
+      auto previous = m_previousChoices.find(selected[net]);
+      if(previous != m_previousChoices.end())
+        warmStart.push_back(previous->second);
+    }
+    if(warmStart.size() != selected.size())
+      warmStart.clear();
+
+    auto selection = m_solver->solve(problem, warmStart, m_clusterTimeBudget);
+    for(std::size_t net = 0; net < selected.size(); ++net)
+    {
+      selected[net]->route = routes[net][selection.choices[net]];
+      map.addRoute(selected[net]->route);
+      m_previousChoices[selected[net]] = selection.choices[net];
+    }
+    return failed;
+  }
+
   protected:
     bool routeNet(common::Net & net) override
     {
-      std::cout << "ILPRipUpAndReRoute trying to route net: " << net.name << std::endl;
+      //without routing resources every net is accepted
+      if(!congestionMap())
+        return true;
 
-      //here goes the code to route the net
-      return true;
+      return routeCluster(NetBatch{&net}).empty();
     }
 
   public:
-    ILPRipUpAndReRoute(std::shared_ptr<RipUpAndReRouteHandler> parent = nullptr) : RipUpAndReRouteHandler(parent)
+    ILPRipUpAndReRoute(std::shared_ptr<RipUpAndReRouteHandler> parent = nullptr, std::shared_ptr<common::CongestionMap> congestionMap = nullptr) :
+      RipUpAndReRouteHandler(parent, congestionMap)
     {
       std::cout << "Constructing ILPRipUpAndReRoute" << std::endl;
     }
@@ -118,14 +624,174 @@ class ILPRipUpAndReRoute : public RipUpAndReRouteHandler
       std::cout << "Destructing ILPRipUpAndReRoute" << std::endl;
     }
 
+    //ILP backend, a branch and bound solver by default
+    void setSolver(std::shared_ptr<common::RouteSelectionSolver> solver)
+    {
+      m_solver = solver;
+    }
+
+    //time given to the solver for each cluster, the best selection found is used when it runs out
+    void setClusterTimeBudget(std::chrono::steady_clock::duration budget)
+    {
+      m_clusterTimeBudget = budget;
+    }
+
+    //the warm starts only hold within a run, the nets of another run may live at the same addresses
+    void startRun() override
+    {
+      m_previousChoices.clear();
+      RipUpAndReRouteHandler::startRun();
+    }
+
+    std::size_t numWarmStarts() const { return m_previousChoices.size(); }
+
     void handleRouteRequest(common::Net & net) override
     {
-      if(!routeNet(net))
+      std::cout << "ILPRipUpAndReRoute trying to route net: " << net.name << std::endl;
+      if(!attemptRoute(net))
       {
         std::cout << "Net Not routed" << std::endl;
         RipUpAndReRouteHandler::handleRouteRequest(net);
       }
     }
+
+    //The nets are solved together, one route selection ILP per cluster of nets with overlapping bounding boxes.
+    //The overflow the ILP cannot avoid is left to the negotiated congestion iterations.
+    void handleRouteRequests(const NetBatch & nets) override
+    {
+      if(!congestionMap())
+      {
+        routeBatch(nets);
+        return;
+      }
+
+      NetBatch failed;
+      for(auto & cluster : clusters(nets))
+      {
+        std::cout << "ILPRipUpAndReRoute trying to route a cluster of " << cluster.size() << " nets" << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        NetBatch clusterFailed = routeCluster(cluster);
+        std::uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        for(auto net : cluster)
+        {
+          recordAttempt(*net, nanoseconds / cluster.size(), std::find(clusterFailed.begin(), clusterFailed.end(), net) == clusterFailed.end());
+        }
+        failed.insert(failed.end(), clusterFailed.begin(), clusterFailed.end());
+      }
+
+      if(!failed.empty())
+      {
+        std::cout << failed.size() << " Nets Not routed" << std::endl;
+        RipUpAndReRouteHandler::handleRouteRequests(failed);
+      }
+    }
+
+    std::string name() const override
+    {
+      return "ILPRipUpAndReRoute";
+    }
+};
+
+//statistics of one iteration of the negotiated congestion router
+struct NegotiatedCongestionIteration
+{
+  unsigned iteration;
+  double seconds;
+  //nets ripped up and sent down the chain again
+  std::size_t netsTouched;
+  std::size_t unroutedNets;
+  std::size_t overflowedEdges;
+  std::uint64_t overflow;
+};
+
+//PathFinder-like negotiated congestion driver over a rip-up-and-reroute chain. Each iteration raises the
+//history cost of the overflowed edges and rips up and reroutes only the nets crossing them, the nets left
+//unrouted and, in the first iteration, the nets without a route, until there is no overflow and every net is routed.
+class NegotiatedCongestionRouter
+{
+  std::shared_ptr<RipUpAndReRouteHandler> m_chain;
+  std::shared_ptr<common::CongestionMap> m_congestionMap;
+  std::uint32_t m_historyIncrement;
+
+  static bool unrouted(const common::Net & net)
+  {
+    return net.pins.size() > 1 && net.route.empty();
+  }
+
+  public:
+    NegotiatedCongestionRouter(std::shared_ptr<RipUpAndReRouteHandler> chain, std::shared_ptr<common::CongestionMap> congestionMap, std::uint32_t historyIncrement = 1) :
+      m_chain(chain), m_congestionMap(congestionMap), m_historyIncrement(historyIncrement)
+    {
+      std::cout << "Constructing NegotiatedCongestionRouter" << std::endl;
+    }
+    ~NegotiatedCongestionRouter()
+    {
+      std::cout << "Destructing NegotiatedCongestionRouter" << std::endl;
+    }
+
+    std::vector<NegotiatedCongestionIteration> run(const NetBatch & nets, unsigned maxIterations)
+    {
+      std::vector<NegotiatedCongestionIteration> iterations;
+      std::vector<char> overflowed(m_congestionMap->numEdges(), 0);
+      std::vector<std::uint32_t> overflowedEdges = m_congestionMap->overflowedEdges();
+      std::vector<char> touched(nets.size(), 0);
+      m_chain->startRun();
+
+      for(unsigned iteration = 0; iteration < maxIterations; ++iteration)
+      {
+        auto start = std::chrono::steady_clock::now();
+
+        m_congestionMap->updateHistoryCosts(m_historyIncrement);
+        for(auto edge : overflowedEdges)
+        {
+          overflowed[edge] = 1;
+        }
+
+        const std::ptrdiff_t size = nets.size();
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic, 256)
+#endif
+        for(std::ptrdiff_t i = 0; i < size; ++i)
+        {
+          const common::Net & net = *nets[i];
+          touched[i] = (iteration == 0 && net.route.empty()) || unrouted(net) ||
+                       std::any_of(net.route.begin(), net.route.end(), [&overflowed](std::uint32_t edge) { return overflowed[edge] != 0; });
+        }
+        for(auto edge : overflowedEdges)
+        {
+          overflowed[edge] = 0;
+        }
+
+        NetBatch batch;
+        for(std::ptrdiff_t i = 0; i < size; ++i)
+        {
+          if(touched[i])
+          {
+            m_congestionMap->removeRoute(nets[i]->route);
+            nets[i]->route.clear();
+            batch.push_back(nets[i]);
+          }
+        }
+        if(!batch.empty())
+          m_chain->handleRouteRequests(batch);
+
+        overflowedEdges = m_congestionMap->overflowedEdges();
+        NegotiatedCongestionIteration statistics{iteration, 0.0, batch.size(), 0, overflowedEdges.size(), 0};
+        statistics.unroutedNets = std::count_if(nets.begin(), nets.end(), [](const common::Net * net) { return unrouted(*net); });
+        for(auto edge : overflowedEdges)
+        {
+          statistics.overflow += m_congestionMap->overflow(edge);
+        }
+        statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        iterations.push_back(statistics);
+
+        std::cout << "Iteration " << iteration << ": " << statistics.netsTouched << " nets rerouted, overflow " << statistics.overflow
+                  << ", " << statistics.unroutedNets << " nets unrouted" << std::endl;
+        if(statistics.overflow == 0 && statistics.unroutedNets == 0)
+          break;
+      }
+      return iterations;
+    }
 };
 
 } //end of namespace behavioral
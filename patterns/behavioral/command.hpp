@@ -1,12 +1,22 @@
 #ifndef PATTERNS_BEHAVIORAL_COMMAND_HPP
 #define PATTERNS_BEHAVIORAL_COMMAND_HPP
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <stack>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #include <boost/variant.hpp>
 
+#include <common/netlist.hpp>
 #include <common/utils.hpp>
 
 namespace behavioral
@@ -43,6 +53,114 @@ class CellTransformer
     }
 };
 
+//Receiver keeping the location and size of every cell in fixed size pages shared by copy on write with the
+//checkpoints. Taking a checkpoint copies the page pointers only; the first write to a shared page copies it.
+//Restoring a checkpoint swaps back the pages that differ from it, so jumping back over any number of
+//commands costs the changed pages instead of replaying the commands.
+class CellStateStore
+{
+  public:
+    static constexpr std::size_t PageSize = 1024;
+
+  private:
+    struct Page
+    {
+      common::Location locations[PageSize];
+      //ids in m_sizes
+      std::uint32_t sizes[PageSize];
+    };
+
+    std::size_t m_numCells;
+    std::vector<std::shared_ptr<Page>> m_pages;
+    //append only, so the ids stay valid in every checkpoint
+    common::NameTable<std::uint32_t> m_sizes;
+
+    Page & writablePage(unsigned cell)
+    {
+      if(cell >= m_numCells)
+        throw std::out_of_range("Unknown cell " + std::to_string(cell));
+      std::shared_ptr<Page> & page = m_pages[cell / PageSize];
+      if(page.use_count() > 1)
+        page = std::make_shared<Page>(*page);
+      return *page;
+    }
+
+    const Page & page(unsigned cell) const
+    {
+      if(cell >= m_numCells)
+        throw std::out_of_range("Unknown cell " + std::to_string(cell));
+      return *m_pages[cell / PageSize];
+    }
+
+  public:
+    class Checkpoint
+    {
+      friend class CellStateStore;
+      std::vector<std::shared_ptr<Page>> m_pages;
+    };
+
+    CellStateStore(std::size_t numCells, common::Location location = common::Location{0, 0}, const std::string & size = "")
+      : m_numCells(numCells), m_pages((numCells + PageSize - 1) / PageSize)
+    {
+      const std::uint32_t sizeId = m_sizes.intern(size);
+      for(auto & page : m_pages)
+      {
+        page = std::make_shared<Page>();
+        std::fill(std::begin(page->locations), std::end(page->locations), location);
+        std::fill(std::begin(page->sizes), std::end(page->sizes), sizeId);
+      }
+    }
+
+    std::size_t numCells() const { return m_numCells; }
+
+    common::Location location(unsigned cell) const { return page(cell).locations[cell % PageSize]; }
+    std::string size(unsigned cell) const { return m_sizes.name(page(cell).sizes[cell % PageSize]); }
+
+    void setLocation(unsigned cell, common::Location location)
+    {
+      writablePage(cell).locations[cell % PageSize] = location;
+    }
+
+    void setSize(unsigned cell, const std::string & size)
+    {
+      const std::uint32_t sizeId = m_sizes.intern(size);
+      writablePage(cell).sizes[cell % PageSize] = sizeId;
+    }
+
+    //receiver interface, for CommandInvoker and TransformJournal
+    void transform(const Transform & transform)
+    {
+      if(transform.type == TransformType::MOVE)
+        setLocation(transform.cell_id, boost::get<common::Location>(transform.newState));
+      else
+        setSize(transform.cell_id, boost::get<std::string>(transform.newState));
+    }
+
+    Checkpoint checkpoint() const
+    {
+      Checkpoint checkpoint;
+      checkpoint.m_pages = m_pages;
+      return checkpoint;
+    }
+
+    //restores the cell states of checkpoint and returns the number of pages that changed since it was taken
+    std::size_t restore(const Checkpoint & checkpoint)
+    {
+      if(checkpoint.m_pages.size() != m_pages.size())
+        throw std::runtime_error("Checkpoint of another cell state store");
+      std::size_t numChangedPages = 0;
+      for(std::size_t index = 0; index < m_pages.size(); ++index)
+      {
+        if(m_pages[index] != checkpoint.m_pages[index])
+        {
+          m_pages[index] = checkpoint.m_pages[index];
+          ++numChangedPages;
+        }
+      }
+      return numChangedPages;
+    }
+};
+
 //command to change a cell characteristic, like size, location, etc
 class Command
 {
@@ -118,8 +236,352 @@ class CommandInvoker
     }
 };
 
-} // end of namespace behavioral
+//Fixed size record of a CellTransform in a TransformJournal. A move keeps its new location and the
+//displacement back to the old one (delta compressed to 16 bits); a resize keeps the ids of its sizes.
+//Moves too long for the delta, resizes and transaction bounds are tagged with Marker in delta[0] and
+//the kind in delta[1].
+struct JournalRecord
+{
+  static constexpr std::int16_t Marker = std::numeric_limits<std::int16_t>::min();
+  enum Kind : std::int16_t {RESIZE, WIDE_MOVE, EXTENSION, GROUP_BEGIN, GROUP_END};
 
-#endif //PATTERNS_BEHAVIORAL_COMMAND_HPP
+  std::uint32_t cell_id;
+  //MOVE: new location, RESIZE: new size id, old size id, EXTENSION: old location of the following WIDE_MOVE,
+  //GROUP_BEGIN/GROUP_END: number of records between them
+  std::uint32_t state[2];
+  //MOVE: old location - new location
+  std::int16_t delta[2];
+
+  bool tagged(Kind kind) const
+  {
+    return delta[0] == Marker && delta[1] == kind;
+  }
+};
+
+static_assert(sizeof(JournalRecord) == 16, "JournalRecord must stay compact");
+
+//Undo/redo journal of CellTransforms for optimizers issuing millions of moves. Every command is one
+//record (two for wide moves) in an arena of fixed size chunks, instead of a heap allocated Command.
+//Undo and redo decode the records and replay them through the receiver, without allocating.
+//With maxUndoDepth > 0 the oldest commands are dropped and their chunks reused.
+//
+//Transforms executed between beginTransaction() and commitTransaction() form a single command: they are
+//undone and redone together, and the listeners (incremental legalization, timing, ...) are notified once
+//per command with the cells it touched, instead of once per transform.
+class TransformJournal
+{
+  using ReceiverFunc = std::function<void(const Transform & transform)>;
+  using ListenerFunc = std::function<void(const std::vector<std::uint32_t> & cells)>;
+
+  public:
+    static constexpr std::size_t ChunkSize = 4096;
+
+  private:
+    ReceiverFunc m_receiver;
+    std::size_t m_maxUndoDepth;
+    common::NameTable<std::uint32_t> m_sizes;
+    std::vector<ListenerFunc> m_listeners;
+    //cells touched by the command being executed, undone or redone
+    std::vector<std::uint32_t> m_touchedCells;
+
+    std::deque<std::unique_ptr<JournalRecord[]>> m_chunks;
+    std::vector<std::unique_ptr<JournalRecord[]>> m_freeChunks;
+    //records are at positions [m_begin, m_end) counted from the first chunk, [m_begin, m_cursor) can be
+    //undone and [m_cursor, m_end) redone
+    std::size_t m_begin = 0;
+    std::size_t m_cursor = 0;
+    std::size_t m_end = 0;
+    std::size_t m_undoDepth = 0;
+    std::size_t m_redoDepth = 0;
+    bool m_inTransaction = false;
+    //the records of the open transaction are [m_transactionBegin, m_end), appended after the redo history,
+    //which is only discarded when the transaction commits
+    std::size_t m_transactionBegin = 0;
+
+    JournalRecord & at(std::size_t position)
+    {
+      return m_chunks[position / ChunkSize][position % ChunkSize];
+    }
+
+    void append(const JournalRecord & record)
+    {
+      if(m_end == m_chunks.size() * ChunkSize)
+      {
+        if(m_freeChunks.empty())
+        {
+          m_chunks.emplace_back(new JournalRecord[ChunkSize]);
+        }
+        else
+        {
+          m_chunks.push_back(std::move(m_freeChunks.back()));
+          m_freeChunks.pop_back();
+        }
+      }
+      at(m_end++) = record;
+    }
+
+    void appendTransform(const Transform & transform)
+    {
+      if(transform.type == TransformType::RESIZE)
+      {
+        append(JournalRecord{transform.cell_id, {m_sizes.intern(boost::get<std::string>(transform.newState)),
+                                                 m_sizes.intern(boost::get<std::string>(transform.oldState))},
+                             {JournalRecord::Marker, JournalRecord::RESIZE}});
+        return;
+      }
+
+      const common::Location & from = boost::get<common::Location>(transform.oldState);
+      const common::Location & to = boost::get<common::Location>(transform.newState);
+      const std::int64_t dx = std::int64_t(from.first) - to.first;
+      const std::int64_t dy = std::int64_t(from.second) - to.second;
+      const std::int64_t limit = std::numeric_limits<std::int16_t>::max();
+      if(dx >= -limit && dx <= limit && dy >= -limit && dy <= limit)
+      {
+        append(JournalRecord{transform.cell_id, {to.first, to.second}, {std::int16_t(dx), std::int16_t(dy)}});
+      }
+      else
+      {
+        append(JournalRecord{transform.cell_id, {from.first, from.second}, {JournalRecord::Marker, JournalRecord::EXTENSION}});
+        append(JournalRecord{transform.cell_id, {to.first, to.second}, {JournalRecord::Marker, JournalRecord::WIDE_MOVE}});
+      }
+    }
+
+    //the redo history is discarded and, when the journal is full, the oldest command is dropped
+    void startCommand()
+    {
+      m_end = m_cursor;
+      m_redoDepth = 0;
+      if(m_maxUndoDepth > 0 && m_undoDepth == m_maxUndoDepth)
+        dropOldest();
+    }
 
+    void dropOldest()
+    {
+      const JournalRecord & oldest = at(m_begin);
+      if(oldest.tagged(JournalRecord::GROUP_BEGIN))
+        m_begin += oldest.state[0] + 2;
+      else
+        m_begin += oldest.tagged(JournalRecord::EXTENSION) ? 2 : 1;
+      --m_undoDepth;
+      while(m_begin >= ChunkSize)
+      {
+        m_freeChunks.push_back(std::move(m_chunks.front()));
+        m_chunks.pop_front();
+        m_begin -= ChunkSize;
+        m_cursor -= ChunkSize;
+        m_end -= ChunkSize;
+      }
+    }
+
+    //replays the transform whose last record is at position, forward or backward
+    void replay(std::size_t position, bool backward)
+    {
+      const JournalRecord & record = at(position);
+      Transform transform;
+      transform.cell_id = record.cell_id;
+      if(record.tagged(JournalRecord::RESIZE))
+      {
+        transform.type = TransformType::RESIZE;
+        transform.oldState = m_sizes.name(record.state[1]);
+        transform.newState = m_sizes.name(record.state[0]);
+      }
+      else
+      {
+        transform.type = TransformType::MOVE;
+        common::Location to{record.state[0], record.state[1]};
+        common::Location from{to.first + record.delta[0], to.second + record.delta[1]};
+        if(record.tagged(JournalRecord::WIDE_MOVE))
+        {
+          const JournalRecord & extension = at(position - 1);
+          from = common::Location{extension.state[0], extension.state[1]};
+        }
+        transform.oldState = from;
+        transform.newState = to;
+      }
+      if(backward)
+        std::swap(transform.oldState, transform.newState);
+      m_receiver(transform);
+      m_touchedCells.push_back(record.cell_id);
+    }
+
+    //undoes the transforms whose records end at position, down to first, and returns the position of the first undone record
+    std::size_t undoTransforms(std::size_t first, std::size_t position)
+    {
+      while(position > first)
+      {
+        replay(position - 1, true);
+        position -= at(position - 1).tagged(JournalRecord::WIDE_MOVE) ? 2 : 1;
+      }
+      return position;
+    }
+
+    //redoes the transforms whose records start at position, up to last, and returns the position after the last redone record
+    std::size_t redoTransforms(std::size_t position, std::size_t last)
+    {
+      while(position < last)
+      {
+        position += at(position).tagged(JournalRecord::EXTENSION) ? 2 : 1;
+        replay(position - 1, false);
+      }
+      return position;
+    }
+
+    void notifyListeners()
+    {
+      if(!m_listeners.empty())
+      {
+        std::sort(m_touchedCells.begin(), m_touchedCells.end());
+        m_touchedCells.erase(std::unique(m_touchedCells.begin(), m_touchedCells.end()), m_touchedCells.end());
+        for(const auto & listener : m_listeners)
+        {
+          listener(m_touchedCells);
+        }
+      }
+      m_touchedCells.clear();
+    }
+
+    //undoes and forgets the records of the open transaction
+    void rollbackTransaction()
+    {
+      m_inTransaction = false;
+      undoTransforms(m_transactionBegin + 1, m_end);
+      m_end = m_transactionBegin;
+      m_touchedCells.clear();
+    }
+
+    void checkNoTransaction() const
+    {
+      if(m_inTransaction)
+        throw std::logic_error("Transform journal operation not allowed inside a transaction");
+    }
+
+  public:
+    TransformJournal(ReceiverFunc receiver, std::size_t maxUndoDepth = 0) : m_receiver(receiver), m_maxUndoDepth(maxUndoDepth)
+    {
+    }
+
+    //listener is called once per executed, undone or redone command with the sorted cells it touched
+    void addListener(ListenerFunc listener)
+    {
+      m_listeners.push_back(listener);
+    }
+
+    //applies transform and records it, discarding the commands that could be redone.
+    //When the receiver throws the journal is left as it was.
+    void executeTransform(const Transform & transform)
+    {
+      m_receiver(transform);
+
+      if(!m_inTransaction)
+        startCommand();
+      appendTransform(transform);
+      m_touchedCells.push_back(transform.cell_id);
+
+      if(!m_inTransaction)
+      {
+        m_cursor = m_end;
+        ++m_undoDepth;
+        notifyListeners();
+      }
+    }
+
+    void beginTransaction()
+    {
+      checkNoTransaction();
+      m_transactionBegin = m_end;
+      append(JournalRecord{0, {0, 0}, {JournalRecord::Marker, JournalRecord::GROUP_BEGIN}});
+      m_inTransaction = true;
+    }
+
+    //records the transforms executed since beginTransaction() as a single command
+    void commitTransaction()
+    {
+      if(!m_inTransaction)
+        throw std::logic_error("No transaction to commit");
+      m_inTransaction = false;
+
+      const std::size_t numRecords = m_end - m_transactionBegin - 1;
+      if(numRecords == 0)
+      {
+        m_end = m_transactionBegin;
+        return;
+      }
+      if(numRecords > std::numeric_limits<std::uint32_t>::max())
+      {
+        rollbackTransaction();
+        throw std::overflow_error("Transaction too large for the transform journal, it was aborted");
+      }
+
+      //the redo history is discarded now, the group is moved over it
+      if(m_transactionBegin != m_cursor)
+      {
+        for(std::size_t position = m_transactionBegin; position < m_end; ++position)
+        {
+          at(m_cursor + position - m_transactionBegin) = at(position);
+        }
+        m_end = m_cursor + numRecords + 1;
+        m_redoDepth = 0;
+      }
+      at(m_cursor).state[0] = numRecords;
+      append(JournalRecord{0, {std::uint32_t(numRecords), 0}, {JournalRecord::Marker, JournalRecord::GROUP_END}});
+      if(m_maxUndoDepth > 0 && m_undoDepth == m_maxUndoDepth)
+        dropOldest();
+      m_cursor = m_end;
+      ++m_undoDepth;
+      notifyListeners();
+    }
+
+    //undoes the transforms executed since beginTransaction() and forgets them, without notifying the listeners.
+    //The undo and redo history is kept as it was before the transaction.
+    void abortTransaction()
+    {
+      if(!m_inTransaction)
+        throw std::logic_error("No transaction to abort");
+      rollbackTransaction();
+    }
+
+    bool undo()
+    {
+      checkNoTransaction();
+      if(m_undoDepth == 0)
+        return false;
+
+      const JournalRecord & last = at(m_cursor - 1);
+      if(last.tagged(JournalRecord::GROUP_END))
+        m_cursor = undoTransforms(m_cursor - 1 - last.state[0], m_cursor - 1) - 1;
+      else
+        m_cursor = undoTransforms(m_cursor - 1, m_cursor);
+      --m_undoDepth;
+      ++m_redoDepth;
+      notifyListeners();
+      return true;
+    }
 
+    bool redo()
+    {
+      checkNoTransaction();
+      if(m_redoDepth == 0)
+        return false;
+
+      const JournalRecord & next = at(m_cursor);
+      if(next.tagged(JournalRecord::GROUP_BEGIN))
+        m_cursor = redoTransforms(m_cursor + 1, m_cursor + 1 + next.state[0]) + 1;
+      else
+        m_cursor = redoTransforms(m_cursor, m_cursor + 1);
+      --m_redoDepth;
+      ++m_undoDepth;
+      notifyListeners();
+      return true;
+    }
+
+    bool inTransaction() const { return m_inTransaction; }
+    std::size_t undoDepth() const { return m_undoDepth; }
+    std::size_t redoDepth() const { return m_redoDepth; }
+    std::size_t numRecords() const { return m_end - m_begin; }
+    //bytes held by the record chunks, including the ones kept for reuse
+    std::size_t memoryUsage() const { return (m_chunks.size() + m_freeChunks.size()) * ChunkSize * sizeof(JournalRecord); }
+};
+
+} // end of namespace behavioral
+
+#endif //PATTERNS_BEHAVIORAL_COMMAND_HPP
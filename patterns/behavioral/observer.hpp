@@ -1,15 +1,30 @@
 #ifndef PATTERNS_BEHAVIORAL_OBSERVER_HPP
 #define PATTERNS_BEHAVIORAL_OBSERVER_HPP
  
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <memory>
-#include <unordered_set>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
 
 #include <common/utils.hpp>
 
 namespace behavioral
 {
  
+  using CellId = unsigned;
+  //id of an erased cell in a remap table
+  constexpr CellId InvalidCellId = std::numeric_limits<CellId>::max();
+
   class Observer
   {
     public: 
@@ -17,9 +32,48 @@ namespace behavioral
       virtual void create() = 0;
       virtual void reserve(unsigned size) = 0;
       virtual unsigned size() = 0;
+
+      //count elements at once, observers storing columns override it to grow them in one shot
+      virtual void createN(unsigned count)
+      {
+        for(unsigned i = 0; i < count; ++i)
+        {
+          create();
+        }
+      }
+
+      //compaction (see StandardCells::compact()): observers supporting it move the element of every cell id
+      //to remap[id] and drop the erased ones (remap[id] == InvalidCellId). Observers written before compaction
+      //existed keep working, the subject refuses to compact while one of them is attached.
+      virtual bool compactable() const
+      {
+        return false;
+      }
+
+      virtual void compact(const std::vector<CellId> & remap)
+      {
+        throw std::logic_error("Observer without compaction support");
+      }
+
+      //concurrent creation mode (see StandardCells::beginConcurrentCreation()): observers supporting it
+      //grow to size from any thread, without relocating their elements
+      virtual bool concurrent() const
+      {
+        return false;
+      }
+
+      virtual void growConcurrent(unsigned size)
+      {
+        throw std::logic_error("Observer without concurrent creation support");
+      }
   };
 
-  using CellId = unsigned;
+  //ids [next, end) reserved by a thread in the concurrent creation mode
+  struct CellIdRange
+  {
+    CellId next = 0;
+    CellId end = 0;
+  };
 
   class Subject 
   {
@@ -29,28 +83,56 @@ namespace behavioral
       virtual void detach(Observer * observer) = 0;
       
       virtual unsigned create() = 0;
+      //creates count elements and returns the id of the first one
+      virtual unsigned createN(unsigned count) = 0;
+      virtual void erase(CellId id) = 0;
+      //renumbers the remaining elements densely, returns the old -> new id remap table
+      virtual const std::vector<CellId> & compact() = 0;
       virtual void reserve(unsigned size) = 0;
       virtual unsigned size() = 0;
   };
 
   class StandardCells : public Subject
   {
-    std::unordered_set< Observer * > m_observers;
+    //in registration order, so the observers are always notified in the same order
+    std::vector< Observer * > m_observers;
+    //m_cellIds[id] is id, or InvalidCellId once the cell is erased (a tombstone kept until compact())
     std::vector<CellId> m_cellIds;
+    std::size_t m_numErased = 0;
+    std::vector<CellId> m_remap;
+
+    //concurrent creation mode
+    bool m_concurrent = false;
+    unsigned m_blockSize = 0;
+    std::atomic<CellId> m_nextId{0};
+    std::mutex m_releasedMutex;
+    std::vector<CellIdRange> m_released;
+
+    void checkNotConcurrent() const
+    {
+      if(m_concurrent)
+        throw std::logic_error("Operation not allowed during concurrent cell creation");
+    }
 
     public:
       void attach(Observer * observer) override
       {
-        m_observers.emplace(observer);
+        checkNotConcurrent();
+        if(std::find(m_observers.begin(), m_observers.end(), observer) == m_observers.end())
+          m_observers.push_back(observer);
       }
       
       void detach(Observer * observer) override
       {
-        m_observers.erase(observer); 
+        checkNotConcurrent();
+        auto position = std::find(m_observers.begin(), m_observers.end(), observer);
+        if(position != m_observers.end())
+          m_observers.erase(position);
       }
 
       unsigned create() override
       {
+        checkNotConcurrent();
         m_cellIds.push_back(m_cellIds.size());
         for(auto & observer : m_observers)
         {
@@ -59,6 +141,140 @@ namespace behavioral
         return m_cellIds.size() - 1;
       }
 
+      //one call per observer for the whole batch, instead of one per cell
+      unsigned createN(unsigned count) override
+      {
+        checkNotConcurrent();
+        const unsigned first = m_cellIds.size();
+        m_cellIds.resize(first + count);
+        std::iota(m_cellIds.begin() + first, m_cellIds.end(), first);
+        for(auto & observer : m_observers)
+        {
+          observer->createN(count);
+        }
+        return first;
+      }
+
+      //the properties of the cell stay allocated until the next compact()
+      void erase(CellId id) override
+      {
+        checkNotConcurrent();
+        if(!alive(id))
+          throw std::out_of_range("Erasing unknown cell " + std::to_string(id));
+        m_cellIds[id] = InvalidCellId;
+        ++m_numErased;
+      }
+
+      bool alive(CellId id) const
+      {
+        return id < m_cellIds.size() && m_cellIds[id] != InvalidCellId;
+      }
+
+      std::size_t numErased() const
+      {
+        return m_numErased;
+      }
+
+      //drops the erased cells and renumbers the others densely, keeping their order. The observers move
+      //their columns in parallel; the old -> new id table stays available through remap() until the next compaction.
+      const std::vector<CellId> & compact() override
+      {
+        checkNotConcurrent();
+        for(auto & observer : m_observers)
+        {
+          if(!observer->compactable())
+            throw std::logic_error("Cell compaction needs observers supporting it");
+        }
+        m_remap.resize(m_cellIds.size());
+        CellId next = 0;
+        for(std::size_t id = 0; id < m_cellIds.size(); ++id)
+        {
+          m_remap[id] = m_cellIds[id] == InvalidCellId ? InvalidCellId : next++;
+        }
+
+        const std::ptrdiff_t numObservers = m_observers.size();
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic)
+#endif
+        for(std::ptrdiff_t observer = 0; observer < numObservers; ++observer)
+        {
+          m_observers[observer]->compact(m_remap);
+        }
+
+        m_cellIds.resize(next);
+        std::iota(m_cellIds.begin(), m_cellIds.end(), 0);
+        m_numErased = 0;
+        return m_remap;
+      }
+
+      const std::vector<CellId> & remap() const
+      {
+        return m_remap;
+      }
+
+      //Concurrent creation mode, for parallel netlist readers: until endConcurrentCreation(), createConcurrent()
+      //may be called from any thread. Every thread takes ids from its own CellIdRange, refilled blockSize ids
+      //at a time with a single atomic increment, and the observers, which must all support the mode, grow
+      //without relocating their elements.
+      void beginConcurrentCreation(unsigned blockSize = 1024)
+      {
+        checkNotConcurrent();
+        for(auto & observer : m_observers)
+        {
+          if(!observer->concurrent())
+            throw std::logic_error("Concurrent cell creation needs observers supporting it");
+        }
+        m_blockSize = std::max(blockSize, 1u);
+        m_nextId.store(m_cellIds.size(), std::memory_order_relaxed);
+        m_concurrent = true;
+      }
+
+      //thread safe, range is owned by the calling thread
+      CellId createConcurrent(CellIdRange & range)
+      {
+        if(range.next == range.end)
+        {
+          const CellId first = m_nextId.fetch_add(m_blockSize, std::memory_order_relaxed);
+          if(first >= InvalidCellId - m_blockSize)
+            throw std::overflow_error("Too many cells for the cell id type");
+          for(auto & observer : m_observers)
+          {
+            observer->growConcurrent(first + m_blockSize);
+          }
+          range = CellIdRange{first, first + m_blockSize};
+        }
+        return range.next++;
+      }
+
+      //gives back the ids left in range, they are erased when the concurrent creation ends
+      void release(CellIdRange & range)
+      {
+        std::lock_guard<std::mutex> lock(m_releasedMutex);
+        m_released.push_back(range);
+        range.next = range.end;
+      }
+
+      //the ids reserved and not released stay alive, with default properties
+      void endConcurrentCreation()
+      {
+        if(!m_concurrent)
+          throw std::logic_error("No concurrent cell creation to end");
+        m_concurrent = false;
+
+        const CellId first = m_cellIds.size();
+        m_cellIds.resize(m_nextId.load(std::memory_order_relaxed));
+        std::iota(m_cellIds.begin() + first, m_cellIds.end(), first);
+        for(const auto & range : m_released)
+        {
+          for(CellId id = range.next; id < range.end; ++id)
+          {
+            m_cellIds[id] = InvalidCellId;
+            ++m_numErased;
+          }
+        }
+        m_released.clear();
+      }
+
       void reserve(unsigned size) override
       {
         m_cellIds.reserve(size);
@@ -74,10 +290,11 @@ namespace behavioral
       }
   };
 
+  //property column, aligned to a cache line for vectorized loops over all the cells
   template <class T>
   class CellProperties : public Observer
   {
-    std::vector<T> m_properties;
+    common::AlignedVector<T> m_properties;
     public:
       
       void create() override
@@ -85,6 +302,33 @@ namespace behavioral
         m_properties.push_back(T());
       }
 
+      void createN(unsigned count) override
+      {
+        m_properties.resize(m_properties.size() + count);
+      }
+
+      bool compactable() const override
+      {
+        return true;
+      }
+
+      void compact(const std::vector<CellId> & remap) override
+      {
+        //new ids never exceed old ones, so moving forward never overwrites an element still to move
+        const std::size_t size = std::min<std::size_t>(m_properties.size(), remap.size());
+        std::size_t numKept = 0;
+        for(std::size_t id = 0; id < size; ++id)
+        {
+          if(remap[id] != InvalidCellId)
+          {
+            if(remap[id] != id)
+              m_properties[remap[id]] = std::move(m_properties[id]);
+            ++numKept;
+          }
+        }
+        m_properties.resize(numKept);
+      }
+
       void reserve(unsigned size) override
       {
         m_properties.reserve(size);
@@ -104,6 +348,313 @@ namespace behavioral
       {
         return m_properties[id];
       }
+
+      T * data()
+      {
+        return m_properties.data();
+      }
+
+      const T * data() const
+      {
+        return m_properties.data();
+      }
+  };
+
+  //Opt-in property column recording which cells changed. Writes go through set() or modify(), and every
+  //consumer (incremental timing, legalization, painting, ...) drains the cells changed or created since its
+  //previous drain, each once, from its own dirty bitset and list: the cost follows the changes, not the cells.
+  template <class T>
+  class TrackedCellProperties : public Observer
+  {
+    struct Consumer
+    {
+      std::vector<std::uint64_t> bits;
+      std::vector<CellId> cells;
+    };
+
+    common::AlignedVector<T> m_properties;
+    std::vector<Consumer> m_consumers;
+
+    void resizeBits()
+    {
+      for(auto & consumer : m_consumers)
+      {
+        consumer.bits.resize((m_properties.size() + 63) / 64, 0);
+      }
+    }
+
+    public:
+      using ConsumerId = unsigned;
+
+      //a new consumer starts with no dirty cell
+      ConsumerId addConsumer()
+      {
+        m_consumers.emplace_back();
+        m_consumers.back().bits.resize((m_properties.size() + 63) / 64, 0);
+        return m_consumers.size() - 1;
+      }
+
+      void markDirty(CellId id)
+      {
+        for(auto & consumer : m_consumers)
+        {
+          std::uint64_t & word = consumer.bits[id / 64];
+          const std::uint64_t bit = std::uint64_t(1) << (id % 64);
+          if(!(word & bit))
+          {
+            word |= bit;
+            consumer.cells.push_back(id);
+          }
+        }
+      }
+
+      void set(CellId id, const T & value)
+      {
+        m_properties[id] = value;
+        markDirty(id);
+      }
+
+      //marks the cell dirty before handing out its property, the reference is valid until the next creation
+      T & modify(CellId id)
+      {
+        markDirty(id);
+        return m_properties[id];
+      }
+
+      const T &operator[](CellId id) const
+      {
+        return m_properties[id];
+      }
+
+      std::size_t numDirty(ConsumerId consumer) const
+      {
+        return m_consumers[consumer].cells.size();
+      }
+
+      //moves the cells changed since the previous drain of consumer into cells, in change order, and starts
+      //a new epoch. The buffer of cells is recycled as the next dirty list.
+      void drain(ConsumerId consumer, std::vector<CellId> & cells)
+      {
+        Consumer & state = m_consumers[consumer];
+        for(auto id : state.cells)
+        {
+          state.bits[id / 64] &= ~(std::uint64_t(1) << (id % 64));
+        }
+        cells.clear();
+        std::swap(cells, state.cells);
+      }
+
+      void create() override
+      {
+        m_properties.push_back(T());
+        resizeBits();
+        markDirty(m_properties.size() - 1);
+      }
+
+      void createN(unsigned count) override
+      {
+        const CellId first = m_properties.size();
+        m_properties.resize(m_properties.size() + count);
+        resizeBits();
+        for(CellId id = first; id < m_properties.size(); ++id)
+        {
+          markDirty(id);
+        }
+      }
+
+      void reserve(unsigned size) override
+      {
+        m_properties.reserve(size);
+      }
+
+      unsigned size() override
+      {
+        return m_properties.size();
+      }
+
+      //the dirty cells are renumbered, the erased ones are dropped
+      bool compactable() const override
+      {
+        return true;
+      }
+
+      void compact(const std::vector<CellId> & remap) override
+      {
+        const std::size_t size = std::min<std::size_t>(m_properties.size(), remap.size());
+        std::size_t numKept = 0;
+        for(std::size_t id = 0; id < size; ++id)
+        {
+          if(remap[id] != InvalidCellId)
+          {
+            if(remap[id] != id)
+              m_properties[remap[id]] = std::move(m_properties[id]);
+            ++numKept;
+          }
+        }
+        m_properties.resize(numKept);
+
+        for(auto & consumer : m_consumers)
+        {
+          std::vector<CellId> cells;
+          cells.swap(consumer.cells);
+          consumer.bits.assign((numKept + 63) / 64, 0);
+          for(auto id : cells)
+          {
+            if(id < remap.size() && remap[id] != InvalidCellId)
+            {
+              consumer.bits[remap[id] / 64] |= std::uint64_t(1) << (remap[id] % 64);
+              consumer.cells.push_back(remap[id]);
+            }
+          }
+        }
+      }
+  };
+
+  //Property column for the concurrent creation mode. The elements live in segments that are allocated once
+  //and never move: the first segment holds FirstSegmentSize elements and every next one doubles the capacity.
+  //Growing only publishes new segments with a compare and swap, so it is lock free, and readers never see
+  //a reallocated buffer while other threads grow the column.
+  template <class T>
+  class ConcurrentCellProperties : public Observer, public boost::noncopyable
+  {
+    static constexpr unsigned FirstSegmentBits = 10;
+    static constexpr std::size_t FirstSegmentSize = std::size_t(1) << FirstSegmentBits;
+    static constexpr unsigned NumSegments = std::numeric_limits<CellId>::digits - FirstSegmentBits + 1;
+
+    std::atomic<T *> m_segments[NumSegments];
+    std::atomic<std::size_t> m_size{0};
+
+    static unsigned segment(std::size_t index)
+    {
+      if(index < FirstSegmentSize)
+        return 0;
+#ifdef __GNUC__
+      return 64 - __builtin_clzll(index >> FirstSegmentBits);
+#else
+      unsigned segment = 0;
+      for(std::size_t block = index >> FirstSegmentBits; block > 0; block >>= 1) ++segment;
+      return segment;
+#endif
+    }
+
+    static std::size_t segmentBegin(unsigned segment)
+    {
+      return segment == 0 ? 0 : FirstSegmentSize << (segment - 1);
+    }
+
+    static std::size_t segmentSize(unsigned segment)
+    {
+      return segment == 0 ? FirstSegmentSize : FirstSegmentSize << (segment - 1);
+    }
+
+    //allocates the segments holding [0, size), the thread losing a race frees its own segment
+    void allocate(std::size_t size)
+    {
+      if(size == 0)
+        return;
+      for(unsigned index = 0; index <= segment(size - 1); ++index)
+      {
+        if(m_segments[index].load(std::memory_order_acquire) == nullptr)
+        {
+          T * fresh = new T[segmentSize(index)]();
+          T * expected = nullptr;
+          if(!m_segments[index].compare_exchange_strong(expected, fresh, std::memory_order_acq_rel))
+            delete[] fresh;
+        }
+      }
+    }
+
+    void grow(std::size_t size)
+    {
+      allocate(size);
+      std::size_t current = m_size.load(std::memory_order_relaxed);
+      while(current < size && !m_size.compare_exchange_weak(current, size, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    public:
+      ConcurrentCellProperties()
+      {
+        for(auto & segment : m_segments)
+        {
+          segment.store(nullptr, std::memory_order_relaxed);
+        }
+      }
+
+      ~ConcurrentCellProperties()
+      {
+        for(auto & segment : m_segments)
+        {
+          delete[] segment.load(std::memory_order_relaxed);
+        }
+      }
+
+      void create() override
+      {
+        grow(size() + 1);
+      }
+
+      void createN(unsigned count) override
+      {
+        grow(size() + count);
+      }
+
+      void reserve(unsigned size) override
+      {
+        allocate(size);
+      }
+
+      unsigned size() override
+      {
+        return m_size.load(std::memory_order_acquire);
+      }
+
+      bool compactable() const override
+      {
+        return true;
+      }
+
+      void compact(const std::vector<CellId> & remap) override
+      {
+        const std::size_t size = std::min<std::size_t>(this->size(), remap.size());
+        std::size_t numKept = 0;
+        for(std::size_t id = 0; id < size; ++id)
+        {
+          if(remap[id] != InvalidCellId)
+          {
+            if(remap[id] != id)
+              (*this)[remap[id]] = std::move((*this)[id]);
+            ++numKept;
+          }
+        }
+        //the freed slots are handed out again by the next creations
+        for(std::size_t id = numKept; id < this->size(); ++id)
+        {
+          (*this)[id] = T();
+        }
+        m_size.store(numKept, std::memory_order_release);
+      }
+
+      bool concurrent() const override
+      {
+        return true;
+      }
+
+      void growConcurrent(unsigned size) override
+      {
+        grow(size);
+      }
+
+      T &operator[](CellId id)
+      {
+        const unsigned index = segment(id);
+        return m_segments[index].load(std::memory_order_acquire)[id - segmentBegin(index)];
+      }
+
+      const T &operator[](CellId id) const
+      {
+        const unsigned index = segment(id);
+        return m_segments[index].load(std::memory_order_acquire)[id - segmentBegin(index)];
+      }
   };
 
 } //end of namespace behavioral
@@ -1,81 +1,715 @@
 #ifndef PATTERNS_STRUCTURAL_BRIDGE_HPP
 #define PATTERNS_STRUCTURAL_BRIDGE_HPP
  
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <functional>
 #include <memory>
+#include <queue>
+#include <stdexcept>
+#include <vector>
 #include <common/utils.hpp>
+#include <common/rctree.hpp>
+#include <common/slackstatistics.hpp>
+#include <common/timinggraph.hpp>
+#include <common/timingsnapshot.hpp>
 
 namespace structural
 {
   class TimingAnalysisImplementation
   {
+    //levels smaller than this are propagated serially, the threading overhead does not pay off
+    static constexpr std::ptrdiff_t MinParallelLevelSize = 1024;
+    //required time of the early (hold) scenario at the end points
+    static constexpr double HoldRequiredTime = 0.0;
+
+    double m_clockPeriod;
+    common::TimingGraph m_graph;
     std::vector<common::TimingPoint> m_topologicalSortedTPs;
-    std::vector<double> m_lateSlacks;
-    std::vector<double> m_earlySlacks;
+    //timing points of level l are m_topologicalSortedTPs[m_levelOffsets[l], m_levelOffsets[l+1])
+    //timing points of the same level do not depend on each other
+    std::vector<std::size_t> m_levelOffsets;
+    std::vector<unsigned> m_levelOfNode;
+    std::vector<std::size_t> m_positionOfNode;
+
+    //incremental timing state
+    bool m_timed = false;
+    //the multi-corner values reflect the current timing graph (they are not updated incrementally)
+    bool m_cornersTimed = false;
+    //bumped at every change of the timing graph or of the timing values
+    std::uint64_t m_epoch = 1;
+    bool m_earlyScenario = false;
+    std::vector<unsigned> m_dirtyNodes;
+    //per level queues reused among updates, so small edits do not allocate
+    std::vector<std::vector<unsigned>> m_levelQueues;
+    std::vector<char> m_queued;
+
+    //Each timing point only reads values of previous levels and writes its own values,
+    //so the result does not depend on the number of threads or on the scheduling
+    template <class Propagate>
+    void propagateLevel(std::size_t level, Propagate propagate)
+    {
+      const std::ptrdiff_t first = m_levelOffsets[level];
+      const std::ptrdiff_t last = m_levelOffsets[level + 1];
+#ifdef _OPENMP
+      #pragma omp parallel for schedule(dynamic, 64) if(last - first >= MinParallelLevelSize)
+#endif
+      for(std::ptrdiff_t i = first; i < last; ++i)
+      {
+        propagate(m_topologicalSortedTPs[i]);
+      }
+    }
+
+    template <class Propagate>
+    void propagateForward(Propagate propagate)
+    {
+      for(std::size_t level = 0; level < numLevels(); ++level)
+      {
+        propagateLevel(level, propagate);
+      }
+    }
+
+    template <class Propagate>
+    void propagateBackward(Propagate propagate)
+    {
+      for(std::size_t level = numLevels(); level > 0; --level)
+      {
+        propagateLevel(level - 1, propagate);
+      }
+    }
+
+    void enqueue(unsigned node)
+    {
+      if(!m_queued[node])
+      {
+        m_queued[node] = 1;
+        m_levelQueues[m_levelOfNode[node]].push_back(node);
+      }
+    }
+
+    //Repropagates the arrival times of the fanout cone of the dirty nodes, level by level.
+    //The propagation stops at the nodes whose arrival times did not change.
+    void updateArrivalCone()
+    {
+      for(auto node : m_dirtyNodes)
+      {
+        enqueue(node);
+      }
+
+      for(std::size_t level = 0; level < numLevels(); ++level)
+      {
+        auto & queue = m_levelQueues[level];
+        for(auto node : queue)
+        {
+          m_queued[node] = 0;
+          double lateArrival = m_lateArrivals[node];
+          double earlyArrival = m_earlyArrivals[node];
+
+          auto & tp = m_topologicalSortedTPs[m_positionOfNode[node]];
+          propagateLateArrival(tp);
+          updateLateSlack(node);
+          if(m_earlyScenario)
+          {
+            propagateEarlyArrival(tp);
+            updateEarlySlack(node);
+          }
+
+          if(lateArrival != m_lateArrivals[node] || earlyArrival != m_earlyArrivals[node])
+          {
+            for(auto position = m_graph.fanoutBegin(node); position < m_graph.fanoutEnd(node); ++position)
+            {
+              enqueue(m_graph.fanoutNode(position));
+            }
+          }
+        }
+        queue.clear();
+      }
+    }
+
+    //Repropagates the required times of the fanin cone of the dirty nodes, from the last level to the first.
+    void updateRequiredCone()
+    {
+      for(auto node : m_dirtyNodes)
+      {
+        enqueue(node);
+      }
+
+      for(std::size_t level = numLevels(); level > 0; --level)
+      {
+        auto & queue = m_levelQueues[level - 1];
+        for(auto node : queue)
+        {
+          m_queued[node] = 0;
+          double lateRequired = m_lateRequireds[node];
+          double earlyRequired = m_earlyRequireds[node];
+
+          auto & tp = m_topologicalSortedTPs[m_positionOfNode[node]];
+          propagateLateRequired(tp);
+          if(m_earlyScenario)
+            propagateEarlyRequired(tp);
+
+          if(lateRequired != m_lateRequireds[node] || earlyRequired != m_earlyRequireds[node])
+          {
+            for(auto position = m_graph.faninBegin(node); position < m_graph.faninEnd(node); ++position)
+            {
+              enqueue(m_graph.faninNode(position));
+            }
+          }
+        }
+        queue.clear();
+      }
+    }
+
+    void updateLateSlack(unsigned node)
+    {
+      m_lateSlacks[node] = m_lateRequireds[node] - m_lateArrivals[node];
+      if(m_graph.isEndPoint(node))
+        m_endPointLateSlacks[m_endPointSlot[node]] = m_lateSlacks[node];
+    }
+
+    void updateEarlySlack(unsigned node)
+    {
+      m_earlySlacks[node] = m_earlyArrivals[node] - m_earlyRequireds[node];
+      if(m_graph.isEndPoint(node))
+        m_endPointEarlySlacks[m_endPointSlot[node]] = m_earlySlacks[node];
+    }
+
+    //Level and position of every node of the sorted graph (nodes in topological order), and resets the timing state
+    void indexSortedGraph(const std::vector<unsigned> & nodes)
+    {
+      m_levelOfNode.resize(nodes.size());
+      m_positionOfNode.resize(nodes.size());
+      for(std::size_t level = 0; level < numLevels(); ++level)
+      {
+        for(auto position = m_levelOffsets[level]; position < m_levelOffsets[level + 1]; ++position)
+        {
+          m_levelOfNode[nodes[position]] = level;
+          m_positionOfNode[nodes[position]] = position;
+        }
+      }
+
+      m_timed = false;
+      m_cornersTimed = false;
+      m_dirtyNodes.clear();
+      ++m_epoch;
+      m_levelQueues.assign(numLevels(), {});
+      m_queued.assign(nodes.size(), 0);
+
+      for(auto values : {&m_lateArrivals, &m_lateRequireds, &m_lateSlacks, &m_earlyArrivals, &m_earlyRequireds, &m_earlySlacks})
+      {
+        values->assign(nodes.size(), 0.0);
+      }
+
+      std::size_t numEndPoints = 0;
+      m_endPointSlot.assign(nodes.size(), 0);
+      for(unsigned node = 0; node < m_graph.numNodes(); ++node)
+      {
+        if(m_graph.isEndPoint(node))
+          m_endPointSlot[node] = numEndPoints++;
+      }
+      m_endPointLateSlacks.assign(numEndPoints, 0.0);
+      m_endPointEarlySlacks.assign(numEndPoints, 0.0);
+    }
+
+    protected:
+      //timing values indexed by timing point id
+      std::vector<double> m_lateArrivals;
+      std::vector<double> m_lateRequireds;
+      std::vector<double> m_lateSlacks;
+      std::vector<double> m_earlyArrivals;
+      std::vector<double> m_earlyRequireds;
+      std::vector<double> m_earlySlacks;
+      //end point slacks stored contiguously (structure of arrays) for the bulk queries
+      std::vector<unsigned> m_endPointSlot;
+      common::AlignedVector<double> m_endPointLateSlacks;
+      common::AlignedVector<double> m_endPointEarlySlacks;
+
+      //multi-corner timing values, the values of all corners of a timing point are contiguous:
+      //value of timing point id in corner c is at id * m_corners.size() + c
+      std::vector<common::TimingCorner> m_corners;
+      common::AlignedVector<double> m_cornerDelayScales;
+      common::AlignedVector<double> m_cornerLateArrivals;
+      common::AlignedVector<double> m_cornerLateRequireds;
+      common::AlignedVector<double> m_cornerEarlyArrivals;
+      common::AlignedVector<double> m_cornerEarlyRequireds;
+
+      const common::TimingGraph & graph() const { return m_graph; }
+
+      void propagateLateArrival(const common::TimingPoint & timingPoint)
+      {
+        unsigned node = timingPoint.id;
+        double arrival = m_graph.isStartPoint(node) ? 0.0 : -std::numeric_limits<double>::infinity();
+        for(auto position = m_graph.faninBegin(node); position < m_graph.faninEnd(node); ++position)
+        {
+          arrival = std::max(arrival, m_lateArrivals[m_graph.faninNode(position)] + m_graph.faninDelay(position));
+        }
+        m_lateArrivals[node] = arrival;
+      }
+
+      void propagateEarlyArrival(const common::TimingPoint & timingPoint)
+      {
+        unsigned node = timingPoint.id;
+        double arrival = m_graph.isStartPoint(node) ? 0.0 : std::numeric_limits<double>::infinity();
+        for(auto position = m_graph.faninBegin(node); position < m_graph.faninEnd(node); ++position)
+        {
+          arrival = std::min(arrival, m_earlyArrivals[m_graph.faninNode(position)] + m_graph.faninDelay(position));
+        }
+        m_earlyArrivals[node] = arrival;
+      }
+
+      void propagateLateRequired(const common::TimingPoint & timingPoint)
+      {
+        unsigned node = timingPoint.id;
+        double required = m_graph.isEndPoint(node) ? m_clockPeriod : std::numeric_limits<double>::infinity();
+        for(auto position = m_graph.fanoutBegin(node); position < m_graph.fanoutEnd(node); ++position)
+        {
+          required = std::min(required, m_lateRequireds[m_graph.fanoutNode(position)] - m_graph.fanoutDelay(position));
+        }
+        m_lateRequireds[node] = required;
+        updateLateSlack(node);
+      }
+
+      void propagateEarlyRequired(const common::TimingPoint & timingPoint)
+      {
+        unsigned node = timingPoint.id;
+        double required = m_graph.isEndPoint(node) ? HoldRequiredTime : -std::numeric_limits<double>::infinity();
+        for(auto position = m_graph.fanoutBegin(node); position < m_graph.fanoutEnd(node); ++position)
+        {
+          required = std::max(required, m_earlyRequireds[m_graph.fanoutNode(position)] - m_graph.fanoutDelay(position));
+        }
+        m_earlyRequireds[node] = required;
+        updateEarlySlack(node);
+      }
+
+      std::size_t cornerIndex(const common::TimingPoint & timingPoint, std::size_t corner) const
+      {
+        if(corner >= m_corners.size() || timingPoint.id >= m_graph.numNodes())
+          throw std::out_of_range("Unknown corner or timing point");
+        return timingPoint.id * m_corners.size() + corner;
+      }
+
+      //propagates all corners at once, the inner loops over the corners are vectorized
+      void propagateCornerArrivals(const common::TimingPoint & timingPoint)
+      {
+        const std::ptrdiff_t numCorners = m_corners.size();
+        const double * scales = m_cornerDelayScales.data();
+        double * late = &m_cornerLateArrivals[timingPoint.id * numCorners];
+        double * early = &m_cornerEarlyArrivals[timingPoint.id * numCorners];
+
+        bool startPoint = m_graph.isStartPoint(timingPoint.id);
+        std::fill(late, late + numCorners, startPoint ? 0.0 : -std::numeric_limits<double>::infinity());
+        std::fill(early, early + numCorners, startPoint ? 0.0 : std::numeric_limits<double>::infinity());
+        for(auto position = m_graph.faninBegin(timingPoint.id); position < m_graph.faninEnd(timingPoint.id); ++position)
+        {
+          const double delay = m_graph.faninDelay(position);
+          const double * faninLate = &m_cornerLateArrivals[m_graph.faninNode(position) * numCorners];
+          const double * faninEarly = &m_cornerEarlyArrivals[m_graph.faninNode(position) * numCorners];
+#ifdef _OPENMP
+          #pragma omp simd
+#endif
+          for(std::ptrdiff_t corner = 0; corner < numCorners; ++corner)
+          {
+            late[corner] = std::max(late[corner], faninLate[corner] + delay * scales[corner]);
+            early[corner] = std::min(early[corner], faninEarly[corner] + delay * scales[corner]);
+          }
+        }
+      }
+
+      void propagateCornerRequireds(const common::TimingPoint & timingPoint)
+      {
+        const std::ptrdiff_t numCorners = m_corners.size();
+        const double * scales = m_cornerDelayScales.data();
+        double * late = &m_cornerLateRequireds[timingPoint.id * numCorners];
+        double * early = &m_cornerEarlyRequireds[timingPoint.id * numCorners];
+
+        if(m_graph.isEndPoint(timingPoint.id))
+        {
+          for(std::ptrdiff_t corner = 0; corner < numCorners; ++corner)
+          {
+            late[corner] = m_corners[corner].clockPeriod;
+            early[corner] = HoldRequiredTime;
+          }
+          return;
+        }
+
+        std::fill(late, late + numCorners, std::numeric_limits<double>::infinity());
+        std::fill(early, early + numCorners, -std::numeric_limits<double>::infinity());
+        for(auto position = m_graph.fanoutBegin(timingPoint.id); position < m_graph.fanoutEnd(timingPoint.id); ++position)
+        {
+          const double delay = m_graph.fanoutDelay(position);
+          const double * fanoutLate = &m_cornerLateRequireds[m_graph.fanoutNode(position) * numCorners];
+          const double * fanoutEarly = &m_cornerEarlyRequireds[m_graph.fanoutNode(position) * numCorners];
+#ifdef _OPENMP
+          #pragma omp simd
+#endif
+          for(std::ptrdiff_t corner = 0; corner < numCorners; ++corner)
+          {
+            late[corner] = std::min(late[corner], fanoutLate[corner] - delay * scales[corner]);
+            early[corner] = std::max(early[corner], fanoutEarly[corner] - delay * scales[corner]);
+          }
+        }
+      }
+
+      //delay of every node of the RC trees according to the delay model (indexed as the arena nodes)
+      virtual void computeNetDelays(const common::RCTreeArena & parasitics, std::vector<double> & delays) = 0;
 
     public:
-      TimingAnalysisImplementation(const std::vector<common::TimingPoint> & timingPoints)
+      //timing points ids must be in [0, timingPoints.size()) and the arcs connect timing point ids
+      TimingAnalysisImplementation(const std::vector<common::TimingPoint> & timingPoints,
+                                   const std::vector<common::TimingArc> & timingArcs = {},
+                                   double clockPeriod = 0.0) : m_clockPeriod(clockPeriod)
       {
-        topologicalSort(timingPoints);
+        topologicalSort(timingPoints, timingArcs);
+      }
+
+      //Restores the sorted timing graph and the timing state of a snapshot without sorting the graph again,
+      //the arrays are copied out of the mapping so the snapshot can be closed afterwards,
+      //runIncremental() continues from the restored state (multi-corner values are not part of the snapshot)
+      explicit TimingAnalysisImplementation(const common::TimingSnapshot & snapshot) : m_clockPeriod(snapshot.clockPeriod()),
+      m_graph(snapshot.numTimingPoints(), snapshot.numArcs(),
+              snapshot.faninOffsets(), snapshot.faninNodes(), snapshot.faninDelays(),
+              snapshot.fanoutOffsets(), snapshot.fanoutNodes(), snapshot.fanoutDelays()),
+      m_topologicalSortedTPs(snapshot.topologicalSortedTPs(), snapshot.topologicalSortedTPs() + snapshot.numTimingPoints()),
+      m_levelOffsets(snapshot.levelOffsets(), snapshot.levelOffsets() + snapshot.numLevels() + 1)
+      {
+        std::vector<unsigned> nodes;
+        nodes.reserve(m_topologicalSortedTPs.size());
+        for(auto & tp : m_topologicalSortedTPs)
+        {
+          nodes.push_back(tp.id);
+        }
+        indexSortedGraph(nodes);
+
+        const std::size_t numNodes = snapshot.numTimingPoints();
+        m_lateArrivals.assign(snapshot.lateArrivals(), snapshot.lateArrivals() + numNodes);
+        m_lateRequireds.assign(snapshot.lateRequireds(), snapshot.lateRequireds() + numNodes);
+        m_lateSlacks.assign(snapshot.lateSlacks(), snapshot.lateSlacks() + numNodes);
+        m_earlyArrivals.assign(snapshot.earlyArrivals(), snapshot.earlyArrivals() + numNodes);
+        m_earlyRequireds.assign(snapshot.earlyRequireds(), snapshot.earlyRequireds() + numNodes);
+        m_earlySlacks.assign(snapshot.earlySlacks(), snapshot.earlySlacks() + numNodes);
+        for(unsigned node = 0; node < numNodes; ++node)
+        {
+          if(m_graph.isEndPoint(node))
+          {
+            m_endPointLateSlacks[m_endPointSlot[node]] = m_lateSlacks[node];
+            m_endPointEarlySlacks[m_endPointSlot[node]] = m_earlySlacks[node];
+          }
+        }
+        m_timed = snapshot.timed();
+        m_earlyScenario = snapshot.earlyScenario();
       }
       virtual ~TimingAnalysisImplementation(){}
 
-      void topologicalSort(const std::vector<common::TimingPoint> & timingPoints)
+      void topologicalSort(const std::vector<common::TimingPoint> & timingPoints, const std::vector<common::TimingArc> & timingArcs = {})
       {
-        //TopologicalSort code goes here
-        m_topologicalSortedTPs = timingPoints;
+        std::vector<common::TimingPoint> timingPointsById(timingPoints.size());
+        for(auto & tp : timingPoints)
+        {
+          timingPointsById.at(tp.id) = tp;
+        }
+
+        m_graph = common::TimingGraph(timingPoints.size(), timingArcs);
+        auto order = m_graph.topologicalSort();
+
+        m_topologicalSortedTPs.clear();
+        m_topologicalSortedTPs.reserve(order.nodes.size());
+        for(auto node : order.nodes)
+        {
+          m_topologicalSortedTPs.push_back(timingPointsById[node]);
+        }
+        m_levelOffsets = std::move(order.levelOffsets);
+        indexSortedGraph(order.nodes);
       }
 
+      std::size_t numLevels() const { return m_levelOffsets.size() - 1; }
+
+      //Full STA. The propagation does not depend on the delay model (the models only differ in the arc delays
+      //they annotate, see computeNetDelays()), so the full and incremental loops call the kernels directly.
       void runLateScenario()
       {
         std::cout << "Running Full STA for Late Scenario " << std::endl;
-        for(auto & tp : m_topologicalSortedTPs)
+        propagateForward([this](const common::TimingPoint & tp)
         {
-          propagateLateScenario(tp);
-        }
+          propagateLateArrival(tp);
+        });
+        propagateBackward([this](const common::TimingPoint & tp)
+        {
+          propagateLateRequired(tp);
+        });
+        m_timed = true;
+        m_earlyScenario = false;
+        m_dirtyNodes.clear();
+        ++m_epoch;
       }
 
       void runLateEarlyScenario()
       {
         std::cout << "Running Full STA for Late/Early Scenario " << std::endl;
-        for(auto & tp : m_topologicalSortedTPs)
+        propagateForward([this](const common::TimingPoint & tp)
+        {
+          propagateLateArrival(tp);
+          propagateEarlyArrival(tp);
+        });
+        propagateBackward([this](const common::TimingPoint & tp)
+        {
+          propagateLateRequired(tp);
+          propagateEarlyRequired(tp);
+        });
+        m_timed = true;
+        m_earlyScenario = true;
+        m_dirtyNodes.clear();
+        ++m_epoch;
+      }
+
+      //Saves the sorted timing graph and the timing state, see common::TimingSnapshot to map it back.
+      //Pending changes are not saved as timed, the restored analysis reruns the full STA.
+      void writeSnapshot(const std::string & file) const
+      {
+        common::writeTimingSnapshot(file, m_topologicalSortedTPs, m_levelOffsets, m_graph,
+                                    {upToDate(), m_earlyScenario, m_clockPeriod,
+                                     m_lateArrivals, m_lateRequireds, m_lateSlacks, m_earlyArrivals, m_earlyRequireds, m_earlySlacks});
+      }
+
+      //K worst late paths, from the worst to the best slack. Best-first search from the end points to the start points:
+      //a partial path from a timing point to an end point is expanded only when the best path completing it
+      //(through the worst arrival time of the timing point) is the worst candidate, so the memory depends on k
+      //and on the depth/fanin of the expanded paths, not on the number of paths of the timing graph.
+      std::vector<common::TimingPath> worstPaths(std::size_t k) const
+      {
+        if(!m_timed)
+          throw std::logic_error("Path reports require a full STA run first");
+
+        //partial path from node to an end point, required is the end point required time minus the delay to node
+        struct PartialPath
+        {
+          unsigned node;
+          double required;
+          std::size_t next;
+        };
+        const std::size_t NoNext = std::numeric_limits<std::size_t>::max();
+        std::vector<PartialPath> partialPaths;
+        using Candidate = std::pair<double, std::size_t>;
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> candidates;
+
+        //the k worst paths end at the k worst end points
+        std::vector<unsigned> endPoints;
+        for(unsigned node = 0; node < m_graph.numNodes(); ++node)
+        {
+          if(m_graph.isEndPoint(node))
+            endPoints.push_back(node);
+        }
+        auto worse = [this](unsigned a, unsigned b) { return std::make_pair(m_lateSlacks[a], a) < std::make_pair(m_lateSlacks[b], b); };
+        if(endPoints.size() > k)
+        {
+          std::nth_element(endPoints.begin(), endPoints.begin() + k, endPoints.end(), worse);
+          endPoints.resize(k);
+        }
+        for(auto node : endPoints)
+        {
+          partialPaths.push_back({node, m_lateRequireds[node], NoNext});
+          candidates.emplace(m_lateSlacks[node], partialPaths.size() - 1);
+        }
+
+        std::vector<common::TimingPath> paths;
+        while(!candidates.empty() && paths.size() < k)
         {
-          propagateLateScenario(tp);
-          propagateEarlyScenario(tp);
+          auto candidate = candidates.top();
+          candidates.pop();
+          PartialPath partialPath = partialPaths[candidate.second];
+
+          if(m_graph.isStartPoint(partialPath.node))
+          {
+            common::TimingPath path{candidate.first, {}};
+            for(auto index = candidate.second; index != NoNext; index = partialPaths[index].next)
+            {
+              path.timingPoints.push_back(partialPaths[index].node);
+            }
+            paths.push_back(std::move(path));
+            continue;
+          }
+
+          for(auto position = m_graph.faninBegin(partialPath.node); position < m_graph.faninEnd(partialPath.node); ++position)
+          {
+            unsigned fanin = m_graph.faninNode(position);
+            double required = partialPath.required - m_graph.faninDelay(position);
+            partialPaths.push_back({fanin, required, candidate.second});
+            candidates.emplace(required - m_lateArrivals[fanin], partialPaths.size() - 1);
+          }
         }
+        return paths;
       }
 
-      double lateSlack(const common::TimingPoint & timingPoint) { return m_lateSlacks.at(timingPoint.pin_id); }
+      //Multi-corner multi-mode STA: late and early values of all corners in a single traversal of the timing graph.
+      //Incremental STA is not supported for this scenario, any change of the timing graph requires a new full run.
+      //The single-corner timing state (see timed()) is left as it is.
+      void runMultiCornerScenario(const std::vector<common::TimingCorner> & corners)
+      {
+        std::cout << "Running Full STA for " << corners.size() << " Corners " << std::endl;
+        m_corners = corners;
+        m_cornerDelayScales.clear();
+        for(auto & corner : m_corners)
+        {
+          m_cornerDelayScales.push_back(corner.delayScale);
+        }
+        for(auto values : {&m_cornerLateArrivals, &m_cornerLateRequireds, &m_cornerEarlyArrivals, &m_cornerEarlyRequireds})
+        {
+          values->assign(m_graph.numNodes() * m_corners.size(), 0.0);
+        }
+
+        propagateForward([this](const common::TimingPoint & tp)
+        {
+          propagateCornerArrivals(tp);
+        });
+        propagateBackward([this](const common::TimingPoint & tp)
+        {
+          propagateCornerRequireds(tp);
+        });
+        m_cornersTimed = true;
+        ++m_epoch;
+      }
+
+      std::size_t numCorners() const { return m_corners.size(); }
+      bool cornersUpToDate() const { return m_cornersTimed; }
+
+      double lateSlack(const common::TimingPoint & timingPoint, std::size_t corner)
+      {
+        auto index = cornerIndex(timingPoint, corner);
+        return m_cornerLateRequireds[index] - m_cornerLateArrivals[index];
+      }
+
+      double earlySlack(const common::TimingPoint & timingPoint, std::size_t corner)
+      {
+        auto index = cornerIndex(timingPoint, corner);
+        return m_cornerEarlyArrivals[index] - m_cornerEarlyRequireds[index];
+      }
+
+      //end point slacks of a corner for the bulk queries, gathered at each call
+      common::AlignedVector<double> endPointLateSlacks(std::size_t corner) const
+      {
+        if(corner >= m_corners.size())
+          throw std::out_of_range("Unknown timing corner");
+        common::AlignedVector<double> slacks;
+        for(unsigned node = 0; node < m_graph.numNodes(); ++node)
+        {
+          if(m_graph.isEndPoint(node))
+            slacks.push_back(m_cornerLateRequireds[node * m_corners.size() + corner] - m_cornerLateArrivals[node * m_corners.size() + corner]);
+        }
+        return slacks;
+      }
+
+      common::AlignedVector<double> endPointEarlySlacks(std::size_t corner) const
+      {
+        if(corner >= m_corners.size())
+          throw std::out_of_range("Unknown timing corner");
+        common::AlignedVector<double> slacks;
+        for(unsigned node = 0; node < m_graph.numNodes(); ++node)
+        {
+          if(m_graph.isEndPoint(node))
+            slacks.push_back(m_cornerEarlyArrivals[node * m_corners.size() + corner] - m_cornerEarlyRequireds[node * m_corners.size() + corner]);
+        }
+        return slacks;
+      }
+
+      //Marks a timing point whose incoming or outgoing delays changed (e.g. after a cell move or resize)
+      void invalidate(const common::TimingPoint & timingPoint)
+      {
+        if(timingPoint.id >= m_graph.numNodes())
+          throw std::out_of_range("Unknown timing point");
+        //only a timed single-corner scenario is updated incrementally, otherwise the next full run picks up the change
+        if(m_timed)
+          m_dirtyNodes.push_back(timingPoint.id);
+        m_cornersTimed = false;
+        ++m_epoch;
+      }
+
+      void setArcDelay(const common::TimingPoint & from, const common::TimingPoint & to, double delay)
+      {
+        m_graph.setArcDelay(from.id, to.id, delay);
+        invalidate(from);
+        invalidate(to);
+      }
+
+      //Sets the delays of the net arcs from their parasitics, all the nets are evaluated in a batch by the delay model
+      void annotateParasitics(const common::RCTreeArena & parasitics, const std::vector<common::NetArcParasitics> & netArcs)
+      {
+        std::vector<double> delays;
+        computeNetDelays(parasitics, delays);
+        for(auto & arc : netArcs)
+        {
+          if(arc.tree >= parasitics.numTrees() || arc.node >= parasitics.treeSize(arc.tree))
+            throw std::out_of_range("Net arc references an unknown RC tree node");
+
+          m_graph.setArcDelay(arc.from, arc.to, delays[parasitics.treeBegin(arc.tree) + arc.node]);
+          if(m_timed)
+          {
+            m_dirtyNodes.push_back(arc.from);
+            m_dirtyNodes.push_back(arc.to);
+          }
+        }
+        m_cornersTimed = false;
+        ++m_epoch;
+      }
+
+      bool timed() const { return m_timed; }
+      //the slacks reflect the current timing graph
+      bool upToDate() const { return m_timed && m_dirtyNodes.empty(); }
+      std::uint64_t epoch() const { return m_epoch; }
+      std::size_t numTimingPoints() const { return m_graph.numNodes(); }
+      bool hasPendingChanges() const { return !m_dirtyNodes.empty(); }
+
+      //Incremental STA: only the arrival cone and the required cone of the dirty timing points
+      //are repropagated, for the same scenario of the last full run
+      void updateTiming()
+      {
+        if(!m_timed)
+          throw std::logic_error("Incremental STA requires a full STA run first");
+
+        if(m_dirtyNodes.empty())
+          return;
+
+        updateArrivalCone();
+        updateRequiredCone();
+        m_dirtyNodes.clear();
+      }
+
+      double lateSlack(const common::TimingPoint & timingPoint) { return m_lateSlacks.at(timingPoint.id); }
       
-      double earlySlack(const common::TimingPoint & timingPoint) { return m_earlySlacks.at(timingPoint.pin_id); }
+      double earlySlack(const common::TimingPoint & timingPoint) { return m_earlySlacks.at(timingPoint.id); }
 
-      virtual void propagateLateScenario(const common::TimingPoint & timingPoint) = 0;
-      virtual void propagateEarlyScenario(const common::TimingPoint & timingPoint) = 0;
+      const common::AlignedVector<double> & endPointLateSlacks() const { return m_endPointLateSlacks; }
+
+      const common::AlignedVector<double> & endPointEarlySlacks() const { return m_endPointEarlySlacks; }
   };
 
   // Simple lumped capacitance and Elmore delay model
   class LumpedCapElmoreDelayTimingAnalysisImplementation : public TimingAnalysisImplementation
   {
     public:
-      LumpedCapElmoreDelayTimingAnalysisImplementation(const std::vector<common::TimingPoint> & timingPoints) :
-      TimingAnalysisImplementation(timingPoints)
+      LumpedCapElmoreDelayTimingAnalysisImplementation(const std::vector<common::TimingPoint> & timingPoints,
+                                                       const std::vector<common::TimingArc> & timingArcs = {},
+                                                       double clockPeriod = 0.0) :
+      TimingAnalysisImplementation(timingPoints, timingArcs, clockPeriod)
       {
         std::cout << "Constructing LumpedCapElmoreDelayTimingAnalysisImplementation" << std::endl;
       }
 
-      ~LumpedCapElmoreDelayTimingAnalysisImplementation()
+      explicit LumpedCapElmoreDelayTimingAnalysisImplementation(const common::TimingSnapshot & snapshot) : TimingAnalysisImplementation(snapshot)
       {
-        std::cout << "Destructing LumpedCapElmoreDelayTimingAnalysisImplementation" << std::endl;
+        std::cout << "Constructing LumpedCapElmoreDelayTimingAnalysisImplementation" << std::endl;
       }
 
-      void propagateLateScenario(const common::TimingPoint & timingPoint) override
+      ~LumpedCapElmoreDelayTimingAnalysisImplementation()
       {
-        std::cout << "..Propagating LumpedCapElmoreDelay for late scenario for tp: " << timingPoint.pin_id <<  std::endl;
+        std::cout << "Destructing LumpedCapElmoreDelayTimingAnalysisImplementation" << std::endl;
       }
 
-      void propagateEarlyScenario(const common::TimingPoint & timingPoint) override
+      void computeNetDelays(const common::RCTreeArena & parasitics, std::vector<double> & delays) override
       {
-        std::cout << "..Propagating LumpedCapElmoreDelay for early scenario for tp: " << timingPoint.pin_id <<  std::endl;
+        common::computeNetDelays<common::LoadModel::LUMPED_CAPACITANCE, common::WireDelayModel::ELMORE>(parasitics, delays);
       }
   };
 
@@ -83,25 +717,27 @@ namespace structural
   class EffectiveCapElmoreDelayTimingAnalysisImplementation : public TimingAnalysisImplementation
   {
     public:
-      EffectiveCapElmoreDelayTimingAnalysisImplementation(const std::vector<common::TimingPoint> & timingPoints) : 
-      TimingAnalysisImplementation(timingPoints)
+      EffectiveCapElmoreDelayTimingAnalysisImplementation(const std::vector<common::TimingPoint> & timingPoints,
+                                                          const std::vector<common::TimingArc> & timingArcs = {},
+                                                          double clockPeriod = 0.0) :
+      TimingAnalysisImplementation(timingPoints, timingArcs, clockPeriod)
       {
         std::cout << "Constructing EffectiveCapElmoreDelayTimingAnalysisImplementation" << std::endl;
       }
 
-      ~EffectiveCapElmoreDelayTimingAnalysisImplementation()
+      explicit EffectiveCapElmoreDelayTimingAnalysisImplementation(const common::TimingSnapshot & snapshot) : TimingAnalysisImplementation(snapshot)
       {
-        std::cout << "Destructing EffectiveCapElmoreDelayTimingAnalysisImplementation" << std::endl;
+        std::cout << "Constructing EffectiveCapElmoreDelayTimingAnalysisImplementation" << std::endl;
       }
 
-      void propagateLateScenario(const common::TimingPoint & timingPoint) override
+      ~EffectiveCapElmoreDelayTimingAnalysisImplementation()
       {
-        std::cout << "..Propagating EffectiveCapElmoreDelay for late scenario for tp: " << timingPoint.pin_id <<  std::endl;
+        std::cout << "Destructing EffectiveCapElmoreDelayTimingAnalysisImplementation" << std::endl;
       }
 
-      void propagateEarlyScenario(const common::TimingPoint & timingPoint) override
+      void computeNetDelays(const common::RCTreeArena & parasitics, std::vector<double> & delays) override
       {
-        std::cout << "..Propagating EffectiveCapElmoreDelay for early scenario for tp: " << timingPoint.pin_id <<  std::endl;
+        common::computeNetDelays<common::LoadModel::EFFECTIVE_CAPACITANCE, common::WireDelayModel::ELMORE>(parasitics, delays);
       }
   };
 
@@ -109,25 +745,27 @@ namespace structural
   class LumpedCapD2MTimingAnalysisImplementation : public TimingAnalysisImplementation
   {
     public:
-      LumpedCapD2MTimingAnalysisImplementation(const std::vector<common::TimingPoint> & timingPoints) :
-      TimingAnalysisImplementation(timingPoints)
+      LumpedCapD2MTimingAnalysisImplementation(const std::vector<common::TimingPoint> & timingPoints,
+                                               const std::vector<common::TimingArc> & timingArcs = {},
+                                               double clockPeriod = 0.0) :
+      TimingAnalysisImplementation(timingPoints, timingArcs, clockPeriod)
       {
         std::cout << "Constructing LumpedCapD2MTimingAnalysisImplementation" << std::endl;
       }
 
-      ~LumpedCapD2MTimingAnalysisImplementation()
+      explicit LumpedCapD2MTimingAnalysisImplementation(const common::TimingSnapshot & snapshot) : TimingAnalysisImplementation(snapshot)
       {
-        std::cout << "Destructing LumpedCapD2MTimingAnalysisImplementation" << std::endl;
+        std::cout << "Constructing LumpedCapD2MTimingAnalysisImplementation" << std::endl;
       }
 
-      void propagateLateScenario(const common::TimingPoint & timingPoint) override
+      ~LumpedCapD2MTimingAnalysisImplementation()
       {
-        std::cout << "..Propagating LumpedCapD2M late scenario for tp: " << timingPoint.pin_id <<  std::endl;
+        std::cout << "Destructing LumpedCapD2MTimingAnalysisImplementation" << std::endl;
       }
 
-      void propagateEarlyScenario(const common::TimingPoint & timingPoint) override
+      void computeNetDelays(const common::RCTreeArena & parasitics, std::vector<double> & delays) override
       {
-        std::cout << "..Propagating LumpedCapD2M for early scenario for tp: " << timingPoint.pin_id <<  std::endl;
+        common::computeNetDelays<common::LoadModel::LUMPED_CAPACITANCE, common::WireDelayModel::D2M>(parasitics, delays);
       }
   };
 
@@ -135,33 +773,114 @@ namespace structural
   class EffectiveCapD2MTimingAnalysisImplementation : public TimingAnalysisImplementation
   {
     public:
-      EffectiveCapD2MTimingAnalysisImplementation(const std::vector<common::TimingPoint> & timingPoints) :
-      TimingAnalysisImplementation(timingPoints)
+      EffectiveCapD2MTimingAnalysisImplementation(const std::vector<common::TimingPoint> & timingPoints,
+                                                  const std::vector<common::TimingArc> & timingArcs = {},
+                                                  double clockPeriod = 0.0) :
+      TimingAnalysisImplementation(timingPoints, timingArcs, clockPeriod)
       {
         std::cout << "Constructing EffectiveCapD2MTimingAnalysisImplementation" << std::endl;
       }
 
-      ~EffectiveCapD2MTimingAnalysisImplementation()
+      explicit EffectiveCapD2MTimingAnalysisImplementation(const common::TimingSnapshot & snapshot) : TimingAnalysisImplementation(snapshot)
       {
-        std::cout << "Destructing EffectiveCapD2MTimingAnalysisImplementation" << std::endl;
+        std::cout << "Constructing EffectiveCapD2MTimingAnalysisImplementation" << std::endl;
       }
 
-      void propagateLateScenario(const common::TimingPoint & timingPoint) override
+      ~EffectiveCapD2MTimingAnalysisImplementation()
       {
-        std::cout << "..Propagating EffectiveCapD2M late scenario for tp: " << timingPoint.pin_id <<  std::endl;
+        std::cout << "Destructing EffectiveCapD2MTimingAnalysisImplementation" << std::endl;
       }
 
-      void propagateEarlyScenario(const common::TimingPoint & timingPoint) override
+      void computeNetDelays(const common::RCTreeArena & parasitics, std::vector<double> & delays) override
       {
-        std::cout << "..Propagating EffectiveCapD2M for early scenario for tp: " << timingPoint.pin_id <<  std::endl;
+        common::computeNetDelays<common::LoadModel::EFFECTIVE_CAPACITANCE, common::WireDelayModel::D2M>(parasitics, delays);
       }
   };
 
+  //what a slack query does when the timing graph changed since the last (incremental) STA
+  enum class StaleSlackPolicy {RECOMPUTE, REPORT_STALE};
+
+  struct SlackCacheStatistics
+  {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t staleQueries = 0;
+    std::size_t recomputes = 0;
+    double recomputeSeconds = 0.0;
+
+    double hitRate() const { return hits + misses > 0 ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+  };
+
   // Bridge
   class TimingAnalysisInterface
   {
     protected:
+      //slack of a timing point and the epoch of the implementation it was read at (0 when never read)
+      struct CachedSlack
+      {
+        double slack = 0.0;
+        std::uint64_t epoch = 0;
+      };
+
       std::unique_ptr<TimingAnalysisImplementation> m_implementation;
+      StaleSlackPolicy m_staleSlackPolicy = StaleSlackPolicy::RECOMPUTE;
+      SlackCacheStatistics m_slackCacheStatistics;
+      std::vector<CachedSlack> m_lateSlackCache;
+
+      const common::AlignedVector<double> & lateEndPointSlacks()
+      {
+        refreshTiming();
+        return m_implementation->endPointLateSlacks();
+      }
+
+      //the timing values of the scenario of this interface reflect the current timing graph
+      virtual bool timingUpToDate() const { return m_implementation->upToDate(); }
+
+      //Applies the stale slack policy before a query: pending changes trigger an incremental STA (RECOMPUTE)
+      //or are counted as a stale query (REPORT_STALE, see slacksStale()). Returns false when the query reads stale timing.
+      bool refreshTiming()
+      {
+        if(timingUpToDate())
+          return true;
+
+        if(m_staleSlackPolicy == StaleSlackPolicy::REPORT_STALE)
+        {
+          ++m_slackCacheStatistics.staleQueries;
+          return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        runIncremental();
+        ++m_slackCacheStatistics.recomputes;
+        m_slackCacheStatistics.recomputeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return true;
+      }
+
+      //Cache of size entries (one per timing point, or per timing point and corner) tagged with the epoch
+      //of the implementation. Under REPORT_STALE the slack cached before the pending changes is returned.
+      template <class Slack>
+      double cachedSlack(std::vector<CachedSlack> & cache, std::size_t size, std::size_t index, Slack slack)
+      {
+        cache.resize(size);
+        if(index >= cache.size())
+          return slack();
+        auto & entry = cache[index];
+
+        if(!refreshTiming())
+          return entry.epoch != 0 ? entry.slack : slack();
+
+        if(entry.epoch == m_implementation->epoch())
+        {
+          ++m_slackCacheStatistics.hits;
+          return entry.slack;
+        }
+
+        ++m_slackCacheStatistics.misses;
+        entry.slack = slack();
+        entry.epoch = m_implementation->epoch();
+        return entry.slack;
+      }
+
     public:
       TimingAnalysisInterface(std::unique_ptr<TimingAnalysisImplementation> && implementation) : m_implementation(std::move(implementation))
       {
@@ -176,12 +895,80 @@ namespace structural
         
       double lateSlack(const common::TimingPoint & timingPoint)
       { 
-        return m_implementation->lateSlack(timingPoint);
+        return cachedSlack(m_lateSlackCache, m_implementation->numTimingPoints(), timingPoint.id, [this, &timingPoint]()
+        {
+          return m_implementation->lateSlack(timingPoint);
+        });
+      }
+
+      // Slack cache
+      void setStaleSlackPolicy(StaleSlackPolicy policy) { m_staleSlackPolicy = policy; }
+
+      bool slacksStale() const { return !timingUpToDate(); }
+
+      const SlackCacheStatistics & slackCacheStatistics() const { return m_slackCacheStatistics; }
+
+      void resetSlackCacheStatistics() { m_slackCacheStatistics = SlackCacheStatistics(); }
+
+      // Bulk queries over the end points, they follow the stale slack policy
+      double worstNegativeLateSlack() { return common::worstNegativeSlack(lateEndPointSlacks()); }
+
+      double totalNegativeLateSlack() { return common::totalNegativeSlack(lateEndPointSlacks()); }
+
+      std::size_t numLateViolations() { return common::numViolations(lateEndPointSlacks()); }
+
+      std::vector<std::size_t> lateSlackHistogram(double lower, double upper, std::size_t numBins)
+      {
+        return common::slackHistogram(lateEndPointSlacks(), lower, upper, numBins);
+      }
+
+      void annotateParasitics(const common::RCTreeArena & parasitics, const std::vector<common::NetArcParasitics> & netArcs)
+      {
+        m_implementation->annotateParasitics(parasitics, netArcs);
+      }
+
+      void writeSnapshot(const std::string & file)
+      {
+        m_implementation->writeSnapshot(file);
+      }
+
+      //follows the stale slack policy
+      std::vector<common::TimingPath> reportWorstPaths(std::size_t k)
+      {
+        refreshTiming();
+        return m_implementation->worstPaths(k);
+      }
+
+      // Incremental STA
+      void invalidate(const common::TimingPoint & timingPoint)
+      {
+        m_implementation->invalidate(timingPoint);
+      }
+
+      void setArcDelay(const common::TimingPoint & from, const common::TimingPoint & to, double delay)
+      {
+        m_implementation->setArcDelay(from, to, delay);
+      }
+
+      virtual void runIncremental()
+      {
+        if(m_implementation->timed())
+          m_implementation->updateTiming();
+        else
+          run();
       }
    };
 
   class LateEarlyTimingAnalysisInterface : public TimingAnalysisInterface
   {
+    std::vector<CachedSlack> m_earlySlackCache;
+
+    const common::AlignedVector<double> & earlyEndPointSlacks()
+    {
+      refreshTiming();
+      return m_implementation->endPointEarlySlacks();
+    }
+
     public:
       LateEarlyTimingAnalysisInterface(std::unique_ptr<TimingAnalysisImplementation> && implementation) : 
       TimingAnalysisInterface(std::move(implementation))
@@ -196,7 +983,125 @@ namespace structural
 
       double earlySlack(const common::TimingPoint & timingPoint)
       {
-        return m_implementation->earlySlack(timingPoint);
+        return cachedSlack(m_earlySlackCache, m_implementation->numTimingPoints(), timingPoint.id, [this, &timingPoint]()
+        {
+          return m_implementation->earlySlack(timingPoint);
+        });
+      }
+
+      double worstNegativeEarlySlack() { return common::worstNegativeSlack(earlyEndPointSlacks()); }
+
+      double totalNegativeEarlySlack() { return common::totalNegativeSlack(earlyEndPointSlacks()); }
+
+      std::size_t numEarlyViolations() { return common::numViolations(earlyEndPointSlacks()); }
+
+      std::vector<std::size_t> earlySlackHistogram(double lower, double upper, std::size_t numBins)
+      {
+        return common::slackHistogram(earlyEndPointSlacks(), lower, upper, numBins);
+      }
+  };
+
+  //Corner-qualified queries: the single-corner slack, bulk and path queries are hidden.
+  //Incremental STA is not supported for the corners, a pending change reruns the full multi-corner STA.
+  class MultiCornerTimingAnalysisInterface : public TimingAnalysisInterface
+  {
+    std::vector<common::TimingCorner> m_corners;
+    //entry of timing point id in corner c is at id * m_corners.size() + c
+    std::vector<CachedSlack> m_cornerLateSlackCache;
+    std::vector<CachedSlack> m_cornerEarlySlackCache;
+
+    using TimingAnalysisInterface::reportWorstPaths;
+    using TimingAnalysisInterface::writeSnapshot;
+
+    //index in the corner caches, out of range for an unknown corner
+    std::size_t cornerCacheIndex(const common::TimingPoint & timingPoint, std::size_t corner) const
+    {
+      if(corner >= m_corners.size())
+        return cornerCacheSize();
+      return timingPoint.id * m_corners.size() + corner;
+    }
+
+    std::size_t cornerCacheSize() const { return m_implementation->numTimingPoints() * m_corners.size(); }
+
+    protected:
+      virtual bool timingUpToDate() const { return m_implementation->cornersUpToDate(); }
+
+    public:
+      MultiCornerTimingAnalysisInterface(std::unique_ptr<TimingAnalysisImplementation> && implementation, const std::vector<common::TimingCorner> & corners) : 
+      TimingAnalysisInterface(std::move(implementation)), m_corners(corners)
+      {
+      }
+
+      virtual void run()
+      {
+        m_implementation->runMultiCornerScenario(m_corners);
+      }
+
+      const std::vector<common::TimingCorner> & corners() const { return m_corners; }
+
+      virtual void runIncremental()
+      {
+        if(!m_implementation->cornersUpToDate())
+          run();
+      }
+
+      double lateSlack(const common::TimingPoint & timingPoint, std::size_t corner)
+      {
+        return cachedSlack(m_cornerLateSlackCache, cornerCacheSize(), cornerCacheIndex(timingPoint, corner), [this, &timingPoint, corner]()
+        {
+          return m_implementation->lateSlack(timingPoint, corner);
+        });
+      }
+
+      double earlySlack(const common::TimingPoint & timingPoint, std::size_t corner)
+      {
+        return cachedSlack(m_cornerEarlySlackCache, cornerCacheSize(), cornerCacheIndex(timingPoint, corner), [this, &timingPoint, corner]()
+        {
+          return m_implementation->earlySlack(timingPoint, corner);
+        });
+      }
+
+      // Bulk queries over the end points of a corner, they follow the stale slack policy
+      double worstNegativeLateSlack(std::size_t corner)
+      {
+        refreshTiming();
+        return common::worstNegativeSlack(m_implementation->endPointLateSlacks(corner));
+      }
+
+      double totalNegativeLateSlack(std::size_t corner)
+      {
+        refreshTiming();
+        return common::totalNegativeSlack(m_implementation->endPointLateSlacks(corner));
+      }
+
+      std::size_t numLateViolations(std::size_t corner)
+      {
+        refreshTiming();
+        return common::numViolations(m_implementation->endPointLateSlacks(corner));
+      }
+
+      std::vector<std::size_t> lateSlackHistogram(std::size_t corner, double lower, double upper, std::size_t numBins)
+      {
+        refreshTiming();
+        return common::slackHistogram(m_implementation->endPointLateSlacks(corner), lower, upper, numBins);
+      }
+
+      double worstNegativeEarlySlack(std::size_t corner)
+      {
+        refreshTiming();
+        return common::worstNegativeSlack(m_implementation->endPointEarlySlacks(corner));
+      }
+
+      double totalNegativeEarlySlack(std::size_t corner)
+      {
+        refreshTiming();
+        return common::totalNegativeSlack(m_implementation->endPointEarlySlacks(corner));
+      }
+
+      std::size_t numEarlyViolations(std::size_t corner)
+      {
+        refreshTiming();
+        return common::numViolations(m_implementation->endPointEarlySlacks(corner));
       }
   };
 
@@ -1,7 +1,20 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#ifdef _OPENMP
+#include <omp.h>
+#include <unistd.h>
+#endif
+#include <common/netlist.hpp>
 #include <common/optimization.hpp>
 #include <common/physicalsynthesissteps.hpp>
 
@@ -142,6 +155,599 @@ TEST_CASE("ChainOfResponsability", "[behavioral][chain_of_responsability]")
     std::cout << "--Rip-up and ReRoute " << net.name << std::endl;
     fastGreedyRipUpAndReRoute->handleRouteRequest(net);
   }
+
+  std::cout << "--Routing telemetry" << std::endl;
+  auto statistics = fastGreedyRipUpAndReRoute->chainStatistics();
+  REQUIRE(statistics.size() == 3);
+  REQUIRE(statistics[0].handler == "FastGreedyRipUpAndReRoute");
+  REQUIRE(statistics[0].attempts == 5);
+  REQUIRE(statistics[0].successes == 2);
+  REQUIRE(statistics[1].attempts == 3);
+  REQUIRE(statistics[1].successes == 2);
+  REQUIRE(statistics[2].attempts == 1);
+  REQUIRE(statistics[2].successRate() == 1.0);
+  for(auto & handlerStatistics : statistics)
+  {
+    REQUIRE(std::accumulate(handlerStatistics.latencyHistogram.begin(), handlerStatistics.latencyHistogram.end(), std::uint64_t(0)) == handlerStatistics.attempts);
+  }
+
+  //in adaptive mode the handlers that keep failing on large nets stop trying them
+  fastGreedyRipUpAndReRoute->resetStatistics();
+  fastGreedyRipUpAndReRoute->setAdaptive(true);
+  std::vector<Net> hardNets(100, Net{"hard", 6});
+  for(auto & net : hardNets)
+  {
+    fastGreedyRipUpAndReRoute->handleRouteRequest(net);
+  }
+  statistics = fastGreedyRipUpAndReRoute->chainStatistics();
+  REQUIRE(statistics[0].successes == 0);
+  REQUIRE(statistics[0].attempts + statistics[0].skipped == hardNets.size());
+  REQUIRE(statistics[0].attempts < 40);
+  REQUIRE(statistics[1].attempts < 40);
+  REQUIRE(statistics[2].attempts == hardNets.size());
+  REQUIRE(statistics[2].skipped == 0);
+  fastGreedyRipUpAndReRoute->setAdaptive(false);
+
+  std::cout << "--Batch Rip-up and ReRoute" << std::endl;
+  std::vector<Net> batchNets;
+  for(unsigned i = 0; i < 128; ++i)
+  {
+    //half of the nets share the same region, the other half are spread over the die
+    Location lower = i % 2 ? Location{10 * i, 10 * i} : Location{0, 0};
+    batchNets.push_back(Net{"b" + std::to_string(i), 2 + i % 6, BoundingBox{lower, Location{lower.first + 5, lower.second + 5}}});
+  }
+  NetBatch batch;
+  for(auto & net : batchNets)
+  {
+    batch.push_back(&net);
+  }
+  fastGreedyRipUpAndReRoute->resetStatistics();
+  REQUIRE_NOTHROW(fastGreedyRipUpAndReRoute->handleRouteRequests(batch));
+  auto numBatchNets = [&](unsigned minPins)
+  {
+    return std::uint64_t(std::count_if(batchNets.begin(), batchNets.end(), [minPins](const Net & net) { return net.num_pins >= minPins; }));
+  };
+  //without routing resources greedy routes the nets with less than 4 pins, A* the ones with less than 6, ILP all of them
+  statistics = fastGreedyRipUpAndReRoute->chainStatistics();
+  REQUIRE(statistics[0].attempts == batchNets.size());
+  REQUIRE(statistics[0].successes == batchNets.size() - numBatchNets(4));
+  REQUIRE(statistics[1].attempts == numBatchNets(4));
+  REQUIRE(statistics[1].successes == numBatchNets(4) - numBatchNets(6));
+  REQUIRE(statistics[2].attempts == numBatchNets(6));
+  REQUIRE(statistics[2].successes == numBatchNets(6));
+
+  //routing the same nets one at a time gives the same statistics
+  fastGreedyRipUpAndReRoute->resetStatistics();
+  for(auto & net : batchNets)
+  {
+    fastGreedyRipUpAndReRoute->handleRouteRequest(net);
+  }
+  auto oneAtATimeStatistics = fastGreedyRipUpAndReRoute->chainStatistics();
+  for(std::size_t handler = 0; handler < statistics.size(); ++handler)
+  {
+    REQUIRE(oneAtATimeStatistics[handler].attempts == statistics[handler].attempts);
+    REQUIRE(oneAtATimeStatistics[handler].successes == statistics[handler].successes);
+  }
+
+  fastGreedyRipUpAndReRoute->resetStatistics();
+  REQUIRE_NOTHROW(fastGreedyRipUpAndReRoute->handleRouteRequests(NetBatch{}));
+  for(auto & handlerStatistics : fastGreedyRipUpAndReRoute->chainStatistics())
+  {
+    REQUIRE(handlerStatistics.attempts == 0);
+  }
+
+  //appends its mark to the route of every net it tries, records the batches it receives and
+  //how many nets of the shared region it routes at the same time
+  struct RecordingRipUpAndReRoute : public RipUpAndReRouteHandler
+  {
+    std::uint32_t mark;
+    unsigned maxPins;
+    std::vector<std::string> received;
+    std::atomic<int> sharedInFlight{0};
+    std::atomic<int> maxSharedInFlight{0};
+
+    RecordingRipUpAndReRoute(std::shared_ptr<RipUpAndReRouteHandler> parent, std::uint32_t mark, unsigned maxPins) :
+      RipUpAndReRouteHandler(parent), mark(mark), maxPins(maxPins) {}
+
+    bool routeNet(Net & net) override
+    {
+      const bool shared = net.bbox.first == Location(0, 0);
+      if(shared)
+      {
+        int inFlight = ++sharedInFlight;
+        int maxInFlight = maxSharedInFlight.load();
+        while(inFlight > maxInFlight && !maxSharedInFlight.compare_exchange_weak(maxInFlight, inFlight)) {}
+      }
+      net.route.push_back(mark);
+      if(shared)
+        --sharedInFlight;
+      return net.num_pins < maxPins;
+    }
+
+    void handleRouteRequest(Net & net) override
+    {
+      if(!attemptRoute(net))
+        RipUpAndReRouteHandler::handleRouteRequest(net);
+    }
+
+    void handleRouteRequests(const NetBatch & nets) override
+    {
+      for(auto net : nets)
+      {
+        received.push_back(net->name);
+      }
+      routeBatch(nets);
+    }
+
+    std::string name() const override { return "Recording" + std::to_string(mark); }
+  };
+  auto lastRecording = std::make_shared<RecordingRipUpAndReRoute>(nullptr, 3, 100);
+  auto middleRecording = std::make_shared<RecordingRipUpAndReRoute>(lastRecording, 2, 6);
+  auto firstRecording = std::make_shared<RecordingRipUpAndReRoute>(middleRecording, 1, 4);
+
+  auto batchRoutedNets = batchNets;
+  NetBatch recordedBatch;
+  for(auto & net : batchRoutedNets)
+  {
+    recordedBatch.push_back(&net);
+  }
+  firstRecording->handleRouteRequests(recordedBatch);
+
+  //every net is tried once by each handler up to the first one routing it
+  std::vector<std::string> escalatedOnce, escalatedTwice, batchNames;
+  for(auto & net : batchRoutedNets)
+  {
+    batchNames.push_back(net.name);
+    std::vector<std::uint32_t> expectedMarks{1};
+    if(net.num_pins >= 4)
+    {
+      expectedMarks.push_back(2);
+      escalatedOnce.push_back(net.name);
+    }
+    if(net.num_pins >= 6)
+    {
+      expectedMarks.push_back(3);
+      escalatedTwice.push_back(net.name);
+    }
+    REQUIRE(net.route == expectedMarks);
+  }
+  //the nets each handler could not route are escalated to the next one in a single batch
+  REQUIRE(firstRecording->received == batchNames);
+  std::sort(middleRecording->received.begin(), middleRecording->received.end());
+  std::sort(escalatedOnce.begin(), escalatedOnce.end());
+  REQUIRE(middleRecording->received == escalatedOnce);
+  std::sort(lastRecording->received.begin(), lastRecording->received.end());
+  std::sort(escalatedTwice.begin(), escalatedTwice.end());
+  REQUIRE(lastRecording->received == escalatedTwice);
+  //the nets sharing a region go to different waves, they are never routed concurrently
+  REQUIRE(firstRecording->maxSharedInFlight == 1);
+  REQUIRE(middleRecording->maxSharedInFlight == 1);
+  REQUIRE(lastRecording->maxSharedInFlight == 1);
+  statistics = firstRecording->chainStatistics();
+  REQUIRE(statistics[0].attempts == batchNets.size());
+  REQUIRE(statistics[1].attempts == escalatedOnce.size());
+  REQUIRE(statistics[2].attempts == escalatedTwice.size());
+  REQUIRE(statistics[2].successes == escalatedTwice.size());
+
+  //the batch results match routing the nets one at a time
+  auto oneAtATimeRoutedNets = batchNets;
+  for(auto & net : oneAtATimeRoutedNets)
+  {
+    firstRecording->handleRouteRequest(net);
+  }
+  for(std::size_t net = 0; net < batchNets.size(); ++net)
+  {
+    REQUIRE(oneAtATimeRoutedNets[net].route == batchRoutedNets[net].route);
+  }
+
+  std::cout << "--GCell grid size limit" << std::endl;
+  REQUIRE(common::GCellGrid(1u << 16, 1u << 14, 1).numEdges() == 3 * (std::size_t(1) << 30));
+  REQUIRE_THROWS_AS(common::GCellGrid(1u << 16, 1u << 14, 2), std::overflow_error &);
+  REQUIRE_THROWS_AS(common::GCellGrid(1u << 16, 1u << 16, 1u << 16), std::overflow_error &);
+
+  std::cout << "--A* maze routing" << std::endl;
+  auto congestionMap = std::make_shared<common::CongestionMap>(common::GCellGrid(16, 16, 4), 1, 4);
+  auto grid = &congestionMap->grid();
+  common::MazeRouter router(*congestionMap);
+  common::MazeRouteScratch scratch;
+
+  //layer 0 is horizontal: a straight route and then a route that needs to climb to the vertical layer
+  Net straight{"straight", 2, BoundingBox{Location{0, 0}, Location{5, 0}}, {Location{0, 0}, Location{5, 0}}};
+  REQUIRE(router.route(straight, scratch));
+  REQUIRE(straight.route.size() == 5);
+  Net vertical{"vertical", 2, BoundingBox{Location{8, 0}, Location{8, 5}}, {Location{8, 0}, Location{8, 5}}};
+  REQUIRE(router.route(vertical, scratch));
+  REQUIRE(vertical.route.size() == 7);
+
+  //the second net on the same row detours through layer 2, the third one finds no capacity left
+  Net detour{"detour", 2, straight.bbox, straight.pins};
+  REQUIRE(router.route(detour, scratch));
+  REQUIRE(detour.route.size() == 9);
+  Net blocked{"blocked", 2, straight.bbox, straight.pins};
+  REQUIRE_FALSE(router.route(blocked, scratch));
+  REQUIRE(blocked.route.empty());
+  for(auto edge : straight.route)
+  {
+    REQUIRE(congestionMap->usage(edge) == 1);
+  }
+
+  //every pin of a multi-pin net is connected by the route
+  Net multiPin{"multiPin", 4, BoundingBox{Location{2, 4}, Location{12, 14}}, {Location{2, 4}, Location{12, 14}, Location{7, 9}, Location{12, 4}}};
+  REQUIRE(router.route(multiPin, scratch));
+  std::vector<unsigned> components(grid->numNodes());
+  std::iota(components.begin(), components.end(), 0);
+  std::function<unsigned(unsigned)> find = [&](unsigned node) { return components[node] == node ? node : components[node] = find(components[node]); };
+  for(auto edge : multiPin.route)
+  {
+    components[find(grid->edgeSource(edge))] = find(grid->edgeTarget(edge));
+  }
+  for(auto & pin : multiPin.pins)
+  {
+    REQUIRE(find(grid->node(pin.first, pin.second, 0)) == find(grid->node(2, 4, 0)));
+  }
+
+  //the A* handler escalates the net it cannot route to the ILP handler
+  auto gridRipUpAndReRoute = std::make_shared<AStarRipUpAndReRoute>(ilpRipUpAndReRoute, congestionMap);
+  Net escalated{"escalated", 2, straight.bbox, straight.pins};
+  REQUIRE_NOTHROW(gridRipUpAndReRoute->handleRouteRequest(escalated));
+  REQUIRE(escalated.route.empty());
+
+  std::cout << "--Congestion map" << std::endl;
+  REQUIRE(congestionMap->totalOverflow() == 0);
+  //concurrent threads commit the same edge without losing updates
+  const std::uint32_t sharedEdge = grid->edge(grid->node(0, 15, 0), common::GCellDirection::EAST);
+#ifdef _OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i = 0; i < 1000; ++i)
+  {
+    congestionMap->addUsage(sharedEdge);
+  }
+  REQUIRE(congestionMap->usage(sharedEdge) == 1000);
+  REQUIRE(congestionMap->overflow(sharedEdge) == 999);
+  REQUIRE(congestionMap->totalOverflow() == 999);
+  REQUIRE(congestionMap->overflowedEdges() == std::vector<std::uint32_t>{sharedEdge});
+  congestionMap->updateHistoryCosts(2);
+  REQUIRE(congestionMap->historyCost(sharedEdge) == 1998);
+  REQUIRE(congestionMap->historyCost(straight.route.front()) == 0);
+
+  //the history cost pushes the searches away from the congested row
+  for(int i = 0; i < 1000; ++i)
+  {
+    congestionMap->removeUsage(sharedEdge);
+  }
+  Net avoiding{"avoiding", 2, BoundingBox{Location{0, 14}, Location{3, 15}}, {Location{0, 15}, Location{3, 15}}};
+  REQUIRE(router.route(avoiding, scratch));
+  REQUIRE(std::find(avoiding.route.begin(), avoiding.route.end(), sharedEdge) == avoiding.route.end());
+
+  //rerouting a routed net rips up its previous route first
+  REQUIRE(router.route(avoiding, scratch));
+  for(auto edge : avoiding.route)
+  {
+    REQUIRE(congestionMap->usage(edge) == 1);
+  }
+
+  //history costs past the bucket queue are searched through the heap, without growing the buckets
+  common::CongestionMap expensiveMap(common::GCellGrid(8, 8, 2), 1, 4);
+  for(std::uint32_t edge = 0; edge < expensiveMap.numEdges(); ++edge)
+  {
+    expensiveMap.addHistoryCost(edge, 100000);
+  }
+  common::MazeRouteScratch expensiveScratch;
+  Net expensive{"expensive", 2, BoundingBox{Location{0, 0}, Location{5, 3}}, {Location{0, 0}, Location{5, 3}}};
+  REQUIRE(common::MazeRouter(expensiveMap).route(expensive, expensiveScratch));
+  REQUIRE(expensive.route.size() == 10);
+  const std::size_t maxBuckets = common::MazeRouteScratch::MaxBuckets;
+  REQUIRE(expensiveScratch.buckets.size() <= maxBuckets);
+  REQUIRE(expensiveScratch.heap.empty());
+
+  //history costs saturate instead of wrapping around
+  expensiveMap.addUsage(expensive.route.front());
+  expensiveMap.updateHistoryCosts(std::numeric_limits<std::uint32_t>::max());
+  REQUIRE(expensiveMap.historyCost(expensive.route.front()) == std::numeric_limits<std::uint32_t>::max());
+  expensiveMap.addHistoryCost(expensive.route.front(), 1);
+  REQUIRE(expensiveMap.historyCost(expensive.route.front()) == std::numeric_limits<std::uint32_t>::max());
+  REQUIRE(common::MazeRouter(expensiveMap).route(expensive, expensiveScratch));
+
+  std::cout << "--Route selection ILP" << std::endl;
+  std::mt19937 ilpGenerator(7);
+  for(int round = 0; round < 20; ++round)
+  {
+    common::RouteSelectionProblem problem;
+    problem.overflowPenalty = 50;
+    problem.freeCapacities.resize(12);
+    for(auto & capacity : problem.freeCapacities) capacity = ilpGenerator() % 3;
+    for(int net = 0; net < 5; ++net)
+    {
+      problem.candidates.emplace_back();
+      for(int candidate = 0; candidate < 4; ++candidate)
+      {
+        common::RouteCandidate route{{}, 10 + ilpGenerator() % 40};
+        for(std::uint32_t edge = 0; edge < 12; ++edge)
+          if(ilpGenerator() % 3 == 0) route.edges.push_back(edge);
+        problem.candidates.back().push_back(route);
+      }
+    }
+
+    //brute force over the 4^5 selections
+    std::uint64_t optimum = std::numeric_limits<std::uint64_t>::max();
+    for(unsigned code = 0; code < 1024; ++code)
+    {
+      std::vector<unsigned> choices;
+      for(int net = 0; net < 5; ++net) choices.push_back((code >> (2 * net)) & 3);
+      optimum = std::min(optimum, common::evaluateRouteSelection(problem, choices).cost);
+    }
+
+    common::BranchAndBoundRouteSelectionSolver solver;
+    auto selection = solver.solve(problem, {}, std::chrono::seconds(10));
+    REQUIRE(selection.optimal);
+    REQUIRE(selection.cost == optimum);
+    REQUIRE(common::evaluateRouteSelection(problem, selection.choices).cost == optimum);
+
+    //starting from the optimum prunes at least as much
+    auto warmSelection = solver.solve(problem, selection.choices, std::chrono::seconds(10));
+    REQUIRE(warmSelection.cost == optimum);
+    REQUIRE(warmSelection.exploredNodes <= selection.exploredNodes);
+
+    //without time the solver still returns a complete selection
+    auto rushedSelection = solver.solve(problem, {}, std::chrono::seconds(0));
+    REQUIRE(rushedSelection.choices.size() == problem.candidates.size());
+    REQUIRE(rushedSelection.cost >= optimum);
+  }
+
+  //three nets on the same row share the two horizontal layers, the ILP router overflows only one edge per GCell
+  auto ilpMap = std::make_shared<common::CongestionMap>(common::GCellGrid(8, 8, 4), 1, 4);
+  auto ilpRouter = std::make_shared<ILPRipUpAndReRoute>(nullptr, ilpMap);
+  std::vector<Net> rowNets(3, Net{"row", 2, BoundingBox{Location{0, 2}, Location{5, 2}}, {Location{0, 2}, Location{5, 2}}});
+  NetBatch rowBatch;
+  for(unsigned i = 0; i < rowNets.size(); ++i)
+  {
+    rowNets[i].name += std::to_string(i);
+    rowBatch.push_back(&rowNets[i]);
+  }
+  ilpRouter->handleRouteRequests(rowBatch);
+  REQUIRE(ilpRouter->statistics().attempts == 3);
+  REQUIRE(ilpRouter->statistics().successes == 3);
+  REQUIRE(ilpMap->totalOverflow() == 5);
+  for(auto & net : rowNets)
+  {
+    REQUIRE_FALSE(net.route.empty());
+  }
+  //routing them again (warm started) keeps the usage consistent
+  ilpRouter->handleRouteRequests(rowBatch);
+  REQUIRE(ilpMap->totalOverflow() == 5);
+  //the warm starts are kept per net, not per name, and only within a run
+  for(auto & net : rowNets)
+  {
+    net.name = "row";
+  }
+  ilpRouter->handleRouteRequests(rowBatch);
+  REQUIRE(ilpRouter->numWarmStarts() == rowNets.size());
+  ilpRouter->startRun();
+  REQUIRE(ilpRouter->numWarmStarts() == 0);
+
+  std::cout << "--Steiner trees" << std::endl;
+  auto spanningLength = [](const std::vector<Location> & points)
+  {
+    //rectilinear minimum spanning tree length (Prim)
+    std::vector<std::uint64_t> distances(points.size(), std::numeric_limits<std::uint64_t>::max());
+    std::vector<char> inTree(points.size(), 0);
+    std::uint64_t length = 0;
+    distances[0] = 0;
+    for(std::size_t step = 0; step < points.size(); ++step)
+    {
+      std::size_t next = points.size();
+      for(std::size_t point = 0; point < points.size(); ++point)
+        if(!inTree[point] && (next == points.size() || distances[point] < distances[next])) next = point;
+      inTree[next] = 1;
+      length += distances[next];
+      for(std::size_t point = 0; point < points.size(); ++point)
+        distances[point] = std::min(distances[point], common::SteinerTree::distance(points[point], points[next]));
+    }
+    return length;
+  };
+  auto connected = [](const common::SteinerTree & tree, std::size_t numPins)
+  {
+    std::vector<unsigned> components(tree.points.size());
+    std::iota(components.begin(), components.end(), 0);
+    std::function<unsigned(unsigned)> find = [&](unsigned point) { return components[point] == point ? point : components[point] = find(components[point]); };
+    for(auto & edge : tree.edges) components[find(edge.first)] = find(edge.second);
+    for(std::size_t pin = 0; pin < numPins; ++pin)
+      if(find(pin) != find(0)) return false;
+    return tree.edges.size() + 1 == tree.points.size();
+  };
+
+  REQUIRE(common::buildSteinerTree({Location{0, 0}, Location{2, 2}, Location{4, 0}}).wirelength() == 6);
+  REQUIRE(common::buildSteinerTree({Location{0, 1}, Location{2, 1}, Location{1, 0}, Location{1, 2}}).wirelength() == 4);
+  REQUIRE(common::buildSteinerTree({Location{3, 3}}).edges.empty());
+
+  std::mt19937 steinerGenerator(11);
+  std::vector<std::vector<Location>> steinerNets;
+  for(int trial = 0; trial < 300; ++trial)
+  {
+    std::vector<Location> pins;
+    for(int pin = 0; pin < 2 + trial % 3; ++pin) pins.emplace_back(steinerGenerator() % 20, steinerGenerator() % 20);
+
+    //exact length: spanning trees of the pins plus up to two Hanan grid points
+    std::uint64_t optimum = spanningLength(pins);
+    std::vector<Location> hanan;
+    for(auto & a : pins) for(auto & b : pins) hanan.emplace_back(a.first, b.second);
+    for(std::size_t a = 0; a < hanan.size(); ++a)
+    {
+      for(std::size_t b = a; b < hanan.size(); ++b)
+      {
+        auto points = pins;
+        points.push_back(hanan[a]);
+        points.push_back(hanan[b]);
+        optimum = std::min(optimum, spanningLength(points));
+      }
+    }
+
+    auto tree = common::buildSteinerTree(pins);
+    REQUIRE(connected(tree, pins.size()));
+    REQUIRE(tree.wirelength() == optimum);
+    steinerNets.push_back(pins);
+  }
+  for(int trial = 0; trial < 50; ++trial)
+  {
+    std::vector<Location> pins;
+    for(int pin = 0; pin < 5 + trial; ++pin) pins.emplace_back(steinerGenerator() % 100, steinerGenerator() % 100);
+    auto tree = common::buildSteinerTree(pins);
+    REQUIRE(connected(tree, pins.size()));
+    REQUIRE(tree.wirelength() <= spanningLength(pins));
+    steinerNets.push_back(pins);
+  }
+  auto steinerTrees = common::buildSteinerTrees(steinerNets);
+  REQUIRE(steinerTrees.size() == steinerNets.size());
+  for(std::size_t net = 0; net < steinerNets.size(); ++net)
+  {
+    REQUIRE(steinerTrees[net].wirelength() == common::buildSteinerTree(steinerNets[net]).wirelength());
+  }
+
+  //the greedy router follows the Steiner tree with L shapes and gives up when they are all full
+  auto greedyMap = std::make_shared<common::CongestionMap>(common::GCellGrid(16, 16, 2), 1, 4);
+  auto greedyRouter = std::make_shared<FastGreedyRipUpAndReRoute>(nullptr, greedyMap);
+  Net greedyNet{"greedy", 3, BoundingBox{Location{1, 1}, Location{9, 7}}, {Location{1, 1}, Location{9, 1}, Location{5, 7}}};
+  greedyRouter->handleRouteRequest(greedyNet);
+  REQUIRE(greedyRouter->statistics().successes == 1);
+  std::uint64_t wires = std::count_if(greedyNet.route.begin(), greedyNet.route.end(), [&](std::uint32_t edge)
+  {
+    return greedyMap->grid().edgeDirection(edge) != common::GCellDirection::UP;
+  });
+  REQUIRE(wires == common::buildSteinerTree(greedyNet.pins).wirelength());
+  Net greedyTwin{"greedyTwin", 3, greedyNet.bbox, greedyNet.pins};
+  greedyRouter->handleRouteRequest(greedyTwin);
+  REQUIRE(greedyRouter->statistics().successes == 1);
+  REQUIRE(greedyTwin.route.empty());
+
+  //rerouting a routed net rips up its previous route, the usage of its edges stays at one
+  std::vector<std::uint32_t> greedyRoute = greedyNet.route;
+  greedyRouter->handleRouteRequest(greedyNet);
+  REQUIRE(greedyRouter->statistics().successes == 2);
+  REQUIRE(greedyNet.route == greedyRoute);
+  for(auto edge : greedyNet.route)
+  {
+    REQUIRE(greedyMap->usage(edge) == 1);
+  }
+  REQUIRE(greedyMap->totalOverflow() == 0);
+
+  std::cout << "--Netlist" << std::endl;
+  common::Netlist<std::uint32_t> netlist;
+  netlist.reserve(3, 2, 5);
+  auto inverter = netlist.addCell("u1", Location{10, 10});
+  auto nand = netlist.addCell("u2", Location{40, 30});
+  auto nor = netlist.addCell("u3", Location{70, 50});
+  auto clock = netlist.addNet("clk");
+  auto data = netlist.addNet("data");
+  REQUIRE_THROWS_AS(netlist.addNet("clk"), std::runtime_error &);
+  REQUIRE_THROWS_AS(netlist.addNet("data"), std::runtime_error &);
+  REQUIRE(netlist.numNets() == 2);
+  REQUIRE_THROWS_AS(netlist.addPin(nor, 7, Location{0, 0}), std::out_of_range &);
+  netlist.addPin(inverter, data, Location{2, 0});
+  netlist.addPin(nand, clock, Location{0, 1});
+  netlist.addPin(nand, data, Location{0, 3});
+  netlist.addPin(nor, data, Location{5, 5});
+  netlist.addPin(nor, clock, Location{1, 1});
+  REQUIRE_THROWS_AS(netlist.netPinsBegin(data), std::logic_error &);
+  netlist.buildAdjacency();
+
+  REQUIRE(netlist.numCells() == 3);
+  REQUIRE(netlist.numNets() == 2);
+  REQUIRE(netlist.findNet("data") == data);
+  REQUIRE(netlist.findNet("reset") == common::Netlist<std::uint32_t>::InvalidId);
+  REQUIRE(netlist.cellName(nand) == "u2");
+  REQUIRE(netlist.netPinsEnd(data) - netlist.netPinsBegin(data) == 3);
+  REQUIRE(netlist.cellPinsEnd(nand) - netlist.cellPinsBegin(nand) == 2);
+  for(std::uint32_t cell = 0; cell < netlist.numCells(); ++cell)
+  {
+    for(auto position = netlist.cellPinsBegin(cell); position < netlist.cellPinsEnd(cell); ++position)
+    {
+      REQUIRE(netlist.pinCell(netlist.cellPin(position)) == cell);
+    }
+  }
+  REQUIRE(netlist.netBoundingBox(data) == BoundingBox(Location{12, 10}, Location{75, 55}));
+
+  //routers receive only the nets they route, in GCells
+  Net dataNet = netlist.routingNet(data, 8, 8);
+  REQUIRE(dataNet.name == "data");
+  REQUIRE(dataNet.num_pins == 3);
+  REQUIRE(dataNet.bbox == BoundingBox(Location{1, 1}, Location{9, 6}));
+  REQUIRE(dataNet.pins == std::vector<Location>({Location{1, 1}, Location{5, 4}, Location{9, 6}}));
+  auto netlistMap = std::make_shared<common::CongestionMap>(common::GCellGrid(16, 16, 4), 2, 4);
+  auto netlistRouter = std::make_shared<FastGreedyRipUpAndReRoute>(std::make_shared<AStarRipUpAndReRoute>(nullptr, netlistMap), netlistMap);
+  netlistRouter->handleRouteRequest(dataNet);
+  REQUIRE_FALSE(dataNet.route.empty());
+
+  //interned names are shared
+  common::NameTable<> names;
+  for(int i = 0; i < 1000; ++i)
+  {
+    REQUIRE(names.intern("n" + std::to_string(i % 100)) == std::uint64_t(i % 100));
+  }
+  REQUIRE(names.size() == 100);
+  REQUIRE(names.name(42) == "n42");
+
+  std::cout << "--Negotiated congestion" << std::endl;
+  auto negotiatedMap = std::make_shared<common::CongestionMap>(common::GCellGrid(32, 32, 4), 2, 8);
+  auto negotiatedILP = std::make_shared<ILPRipUpAndReRoute>(nullptr, negotiatedMap);
+  auto negotiatedAStar = std::make_shared<AStarRipUpAndReRoute>(negotiatedILP, negotiatedMap);
+  NegotiatedCongestionRouter negotiatedRouter(negotiatedAStar, negotiatedMap);
+
+  std::vector<Net> negotiatedNets;
+  for(unsigned i = 0; i < 24; ++i)
+  {
+    Location source{i % 8, 4 * (i / 8)}, sink{24 + i % 8, 4 * (i / 8) + 8};
+    negotiatedNets.push_back(Net{"nc" + std::to_string(i), 2, BoundingBox{source, sink}, {source, sink}});
+  }
+  NetBatch negotiatedBatch;
+  for(auto & net : negotiatedNets)
+  {
+    negotiatedBatch.push_back(&net);
+  }
+
+  auto iterations = negotiatedRouter.run(negotiatedBatch, 10);
+  REQUIRE(iterations.size() == 1);
+  REQUIRE(iterations.front().netsTouched == negotiatedNets.size());
+  REQUIRE(iterations.front().overflow == 0);
+  REQUIRE(iterations.front().unroutedNets == 0);
+
+  //shrinking the capacity of the wires used above the pin layer creates overflow, only the nets crossing them are rerouted
+  std::vector<char> usedEdges(negotiatedMap->numEdges(), 0);
+  for(auto edge : negotiatedNets.front().route)
+  {
+    auto & negotiatedGrid = negotiatedMap->grid();
+    if(negotiatedGrid.edgeDirection(edge) != common::GCellDirection::UP && negotiatedGrid.layer(negotiatedGrid.edgeSource(edge)) > 0)
+    {
+      negotiatedMap->setCapacity(edge, 0);
+      usedEdges[edge] = 1;
+    }
+  }
+  std::size_t crossingNets = std::count_if(negotiatedNets.begin(), negotiatedNets.end(), [&](const Net & net)
+  {
+    return std::any_of(net.route.begin(), net.route.end(), [&](std::uint32_t edge) { return usedEdges[edge] != 0; });
+  });
+  iterations = negotiatedRouter.run(negotiatedBatch, 10);
+  REQUIRE(iterations.front().netsTouched == crossingNets);
+  REQUIRE(iterations.front().netsTouched < negotiatedNets.size());
+  REQUIRE(iterations.back().overflow == 0);
+  REQUIRE(negotiatedMap->totalOverflow() == 0);
+  for(auto & net : negotiatedNets)
+  {
+    REQUIRE_FALSE(net.route.empty());
+    for(auto edge : net.route)
+    {
+      REQUIRE(usedEdges[edge] == 0);
+    }
+  }
+
+  //a net without any free resource keeps the router iterating although there is no overflow
+  auto blockedMap = std::make_shared<common::CongestionMap>(common::GCellGrid(4, 4, 2), 0, 0);
+  NegotiatedCongestionRouter blockedRouter(std::make_shared<AStarRipUpAndReRoute>(nullptr, blockedMap), blockedMap);
+  Net unroutable{"unroutable", 2, BoundingBox{Location{0, 0}, Location{3, 0}}, {Location{0, 0}, Location{3, 0}}};
+  iterations = blockedRouter.run(NetBatch{&unroutable}, 3);
+  REQUIRE(iterations.size() == 3);
+  REQUIRE(iterations.back().overflow == 0);
+  REQUIRE(iterations.back().unroutedNets == 1);
 }
 
 TEST_CASE("Command", "[behavioral][command]") 
@@ -189,6 +795,269 @@ TEST_CASE("Command", "[behavioral][command]")
   invoker.redo();
   invoker.redo();
   invoker.redo();
+
+  std::cout << "--Transform journal" << std::endl;
+  const std::size_t numCells = 64;
+  std::vector<Location> locations(numCells, Location{1000, 1000});
+  std::vector<std::string> sizes(numCells, "X1");
+  std::size_t numReplayed = 0;
+  auto apply = [&](const Transform & transform) {
+    ++numReplayed;
+    if(transform.type == TransformType::MOVE)
+    {
+      REQUIRE(locations[transform.cell_id] == boost::get<Location>(transform.oldState));
+      locations[transform.cell_id] = boost::get<Location>(transform.newState);
+    }
+    else
+    {
+      REQUIRE(sizes[transform.cell_id] == boost::get<std::string>(transform.oldState));
+      sizes[transform.cell_id] = boost::get<std::string>(transform.newState);
+    }
+  };
+  const std::vector<Location> initialLocations = locations;
+  const std::vector<std::string> initialSizes = sizes;
+
+  TransformJournal journal(apply);
+  REQUIRE_FALSE(journal.undo());
+  std::mt19937 generator(7);
+  std::uniform_int_distribution<unsigned> cellDistribution(0, numCells - 1);
+  std::uniform_int_distribution<unsigned> stepDistribution(0, 200);
+  const std::vector<std::string> sizeNames{"X1", "X2", "X4", "X8"};
+  const std::size_t numTransforms = 3 * TransformJournal::ChunkSize;
+  for(std::size_t i = 0; i < numTransforms; ++i)
+  {
+    unsigned cell = cellDistribution(generator);
+    if(i % 5 == 0)
+    {
+      journal.executeTransform(Transform{cell, TransformType::RESIZE, sizes[cell], sizeNames[i % sizeNames.size()]});
+    }
+    else
+    {
+      //every 7th move is too long for the 16 bit delta
+      unsigned step = i % 7 == 0 ? 100000 : stepDistribution(generator);
+      Location to = i % 2 ? Location{locations[cell].first + step, locations[cell].second}
+                          : Location{locations[cell].first, step};
+      journal.executeTransform(Transform{cell, TransformType::MOVE, locations[cell], to});
+    }
+  }
+  const std::vector<Location> finalLocations = locations;
+  const std::vector<std::string> finalSizes = sizes;
+  REQUIRE(journal.undoDepth() == numTransforms);
+  REQUIRE(journal.numRecords() > numTransforms);
+  REQUIRE(journal.memoryUsage() <= 2 * numTransforms * sizeof(JournalRecord) + TransformJournal::ChunkSize * sizeof(JournalRecord));
+
+  while(journal.undo());
+  REQUIRE(journal.redoDepth() == numTransforms);
+  REQUIRE(locations == initialLocations);
+  REQUIRE(sizes == initialSizes);
+  while(journal.redo());
+  REQUIRE(locations == finalLocations);
+  REQUIRE(sizes == finalSizes);
+  REQUIRE(numReplayed == 3 * numTransforms);
+
+  //a new transform discards the redo history
+  journal.undo();
+  journal.executeTransform(Transform{0, TransformType::RESIZE, sizes[0], "X16"});
+  REQUIRE(journal.redoDepth() == 0);
+  REQUIRE_FALSE(journal.redo());
+
+  //capped journal: only the last maxUndoDepth transforms can be undone, and the chunks are reused
+  const std::size_t maxUndoDepth = 1000;
+  TransformJournal cappedJournal(apply, maxUndoDepth);
+  std::vector<Location> checkpoint;
+  for(std::size_t i = 0; i < 4 * TransformJournal::ChunkSize; ++i)
+  {
+    if(i == 4 * TransformJournal::ChunkSize - maxUndoDepth)
+      checkpoint = locations;
+    unsigned cell = cellDistribution(generator);
+    unsigned step = i % 3 == 0 ? 70000 : stepDistribution(generator);
+    cappedJournal.executeTransform(Transform{cell, TransformType::MOVE, locations[cell], Location{step, locations[cell].second}});
+  }
+  REQUIRE(cappedJournal.undoDepth() == maxUndoDepth);
+  REQUIRE(cappedJournal.memoryUsage() <= 3 * TransformJournal::ChunkSize * sizeof(JournalRecord));
+  while(cappedJournal.undo());
+  REQUIRE(locations == checkpoint);
+
+  std::cout << "--Transform transactions" << std::endl;
+  std::size_t numNotifications = 0;
+  std::vector<std::uint32_t> notifiedCells;
+  TransformJournal transactionJournal(apply, 4);
+  transactionJournal.addListener([&](const std::vector<std::uint32_t> & cells) {
+    ++numNotifications;
+    notifiedCells = cells;
+  });
+
+  transactionJournal.executeTransform(Transform{0, TransformType::MOVE, locations[0], Location{5, 5}});
+  REQUIRE(numNotifications == 1);
+  REQUIRE(notifiedCells == std::vector<std::uint32_t>{0});
+
+  const std::vector<Location> beforeLocations = locations;
+  const std::vector<std::string> beforeSizes = sizes;
+  const std::size_t numGrouped = 5000;
+  transactionJournal.beginTransaction();
+  REQUIRE_THROWS_AS(transactionJournal.beginTransaction(), std::logic_error &);
+  REQUIRE_THROWS_AS(transactionJournal.undo(), std::logic_error &);
+  for(std::size_t i = 0; i < numGrouped; ++i)
+  {
+    unsigned cell = cellDistribution(generator);
+    if(i % 3 == 0)
+      transactionJournal.executeTransform(Transform{cell, TransformType::RESIZE, sizes[cell], sizeNames[i % sizeNames.size()]});
+    else
+      transactionJournal.executeTransform(Transform{cell, TransformType::MOVE, locations[cell], Location{i % 2 ? 90000 : i, 7}});
+  }
+  REQUIRE(numNotifications == 1);
+  transactionJournal.commitTransaction();
+  const std::vector<Location> afterLocations = locations;
+  const std::vector<std::string> afterSizes = sizes;
+  REQUIRE(numNotifications == 2);
+  REQUIRE(notifiedCells.size() == numCells);
+  REQUIRE(transactionJournal.undoDepth() == 2);
+
+  //the whole transaction is undone and redone as one command, with a single notification
+  REQUIRE(transactionJournal.undo());
+  REQUIRE(numNotifications == 3);
+  REQUIRE(locations == beforeLocations);
+  REQUIRE(sizes == beforeSizes);
+  REQUIRE(transactionJournal.undo());
+  REQUIRE(transactionJournal.redo());
+  REQUIRE(transactionJournal.redo());
+  REQUIRE(numNotifications == 6);
+  REQUIRE(locations == afterLocations);
+  REQUIRE(sizes == afterSizes);
+
+  //an aborted transaction leaves no trace
+  transactionJournal.beginTransaction();
+  transactionJournal.executeTransform(Transform{1, TransformType::MOVE, locations[1], Location{100000, 3}});
+  transactionJournal.executeTransform(Transform{2, TransformType::RESIZE, sizes[2], "X32"});
+  transactionJournal.abortTransaction();
+  REQUIRE(numNotifications == 6);
+  REQUIRE(locations == afterLocations);
+  REQUIRE(sizes == afterSizes);
+  REQUIRE(transactionJournal.undoDepth() == 2);
+  REQUIRE(transactionJournal.redoDepth() == 0);
+
+  //transactions are dropped as a whole by the undo depth cap
+  for(unsigned i = 0; i < 6; ++i)
+  {
+    transactionJournal.beginTransaction();
+    transactionJournal.executeTransform(Transform{i, TransformType::MOVE, locations[i], Location{i, i}});
+    transactionJournal.executeTransform(Transform{i + 1, TransformType::MOVE, locations[i + 1], Location{i + 1, 80000}});
+    transactionJournal.commitTransaction();
+  }
+  REQUIRE(transactionJournal.undoDepth() == 4);
+  REQUIRE(transactionJournal.numRecords() <= 4 * 6);
+  while(transactionJournal.undo());
+  REQUIRE(locations[2] == Location(2, 80000));
+  REQUIRE(locations[6] == afterLocations[6]);
+
+  //an aborted transaction keeps the redo history, a committed one discards it
+  const std::vector<Location> undoneLocations = locations;
+  transactionJournal.beginTransaction();
+  transactionJournal.executeTransform(Transform{1, TransformType::MOVE, locations[1], Location{100000, 3}});
+  transactionJournal.abortTransaction();
+  REQUIRE(locations == undoneLocations);
+  REQUIRE(transactionJournal.redoDepth() == 4);
+  REQUIRE(transactionJournal.redo());
+  REQUIRE(locations[2] == Location(2, 2));
+  REQUIRE(transactionJournal.undo());
+  transactionJournal.beginTransaction();
+  transactionJournal.executeTransform(Transform{1, TransformType::MOVE, locations[1], Location{100000, 3}});
+  transactionJournal.commitTransaction();
+  REQUIRE(transactionJournal.redoDepth() == 0);
+  REQUIRE_FALSE(transactionJournal.redo());
+  REQUIRE(transactionJournal.undoDepth() == 1);
+  REQUIRE(transactionJournal.undo());
+  REQUIRE(locations == undoneLocations);
+  REQUIRE(transactionJournal.redo());
+  REQUIRE(locations[1] == Location(100000, 3));
+
+  //a full journal only drops its oldest command when a transaction commits
+  const Location initialLocation = locations[3];
+  TransformJournal fullJournal(apply, 1);
+  fullJournal.executeTransform(Transform{3, TransformType::MOVE, locations[3], Location{1, 2}});
+  fullJournal.beginTransaction();
+  fullJournal.executeTransform(Transform{4, TransformType::MOVE, locations[4], Location{3, 4}});
+  fullJournal.abortTransaction();
+  REQUIRE(fullJournal.undoDepth() == 1);
+  REQUIRE(fullJournal.undo());
+  REQUIRE(locations[3] == initialLocation);
+  REQUIRE(fullJournal.redo());
+  fullJournal.beginTransaction();
+  fullJournal.executeTransform(Transform{4, TransformType::MOVE, locations[4], Location{3, 4}});
+  fullJournal.commitTransaction();
+  REQUIRE(fullJournal.undoDepth() == 1);
+  REQUIRE(fullJournal.undo());
+  REQUIRE_FALSE(fullJournal.undo());
+  REQUIRE(locations[3] == Location(1, 2));
+  REQUIRE(fullJournal.redo());
+
+  //a transform rejected by the receiver leaves the undo and redo history as it was
+  auto rejectCell5 = [&](const Transform & transform)
+  {
+    if(transform.cell_id == 5)
+      throw std::runtime_error("Cell 5 is fixed");
+    apply(transform);
+  };
+  TransformJournal rejectingJournal(rejectCell5, 1);
+  const Location rejectedLocation = locations[3];
+  rejectingJournal.executeTransform(Transform{3, TransformType::MOVE, locations[3], Location{5, 6}});
+  REQUIRE_THROWS_AS(rejectingJournal.executeTransform(Transform{5, TransformType::MOVE, locations[5], Location{7, 8}}), std::runtime_error &);
+  REQUIRE(rejectingJournal.undoDepth() == 1);
+  REQUIRE(rejectingJournal.undo());
+  REQUIRE(locations[3] == rejectedLocation);
+  REQUIRE_THROWS_AS(rejectingJournal.executeTransform(Transform{5, TransformType::MOVE, locations[5], Location{7, 8}}), std::runtime_error &);
+  REQUIRE(rejectingJournal.redoDepth() == 1);
+  REQUIRE(rejectingJournal.redo());
+  REQUIRE(locations[3] == Location(5, 6));
+
+  std::cout << "--Cell state checkpoints" << std::endl;
+  const std::size_t numStoredCells = 40 * CellStateStore::PageSize;
+  CellStateStore store(numStoredCells, Location{10, 10}, "X1");
+  REQUIRE_THROWS_AS(store.location(numStoredCells), std::out_of_range &);
+  TransformJournal storeJournal(std::bind(&CellStateStore::transform, &store, std::placeholders::_1));
+
+  //moves of the what-if exploration only touch cells of the first three pages
+  std::uniform_int_distribution<unsigned> localCellDistribution(0, 3 * CellStateStore::PageSize - 1);
+  auto explore = [&](std::size_t numMoves) {
+    for(std::size_t i = 0; i < numMoves; ++i)
+    {
+      unsigned cell = localCellDistribution(generator);
+      if(i % 10 == 0)
+        storeJournal.executeTransform(Transform{cell, TransformType::RESIZE, store.size(cell), sizeNames[i % sizeNames.size()]});
+      else
+        storeJournal.executeTransform(Transform{cell, TransformType::MOVE, store.location(cell), Location{unsigned(i % 500), unsigned(i % 300)}});
+    }
+  };
+
+  auto initialState = store.checkpoint();
+  explore(100000);
+  auto exploredState = store.checkpoint();
+  std::vector<Location> exploredLocations;
+  for(unsigned cell = 0; cell < numStoredCells; ++cell)
+  {
+    exploredLocations.push_back(store.location(cell));
+  }
+  explore(1000);
+
+  REQUIRE(store.restore(initialState) == 3);
+  for(unsigned cell = 0; cell < numStoredCells; ++cell)
+  {
+    REQUIRE(store.location(cell) == Location(10, 10));
+    REQUIRE(store.size(cell) == "X1");
+  }
+  REQUIRE(store.restore(initialState) == 0);
+
+  REQUIRE(store.restore(exploredState) == 3);
+  for(unsigned cell = 0; cell < numStoredCells; ++cell)
+  {
+    REQUIRE(store.location(cell) == exploredLocations[cell]);
+  }
+  //writes after a restore do not leak into the checkpoint
+  store.setLocation(0, Location{1, 1});
+  REQUIRE(store.restore(exploredState) == 1);
+  REQUIRE(store.location(0) == exploredLocations[0]);
+  store.restore(initialState);
+  REQUIRE_THROWS_AS(store.restore(CellStateStore(1).checkpoint()), std::runtime_error &);
 }
 
 TEST_CASE("Observer", "[behavioral][observer]") 
@@ -224,6 +1093,189 @@ TEST_CASE("Observer", "[behavioral][observer]")
   CellId c5 = stdCells.create();
 
   std::cout << "The properties have size " << cellNames.size() << " and " << cellAreas.size() << std::endl;
+  REQUIRE(c5 == c4 + 1);
+
+  std::cout << "--Bulk creation" << std::endl;
+  CellProperties<double> cellWidths;
+  stdCells.attach(&cellWidths);
+  stdCells.attach(&cellWidths);
+  stdCells.reserve(100005);
+  CellId first = stdCells.createN(100000);
+  REQUIRE(first == 5);
+  REQUIRE(stdCells.size() == 100005);
+  REQUIRE(cellNames.size() == 100005);
+  REQUIRE(cellWidths.size() == 100000);
+  REQUIRE(cellAreas.size() == 3);
+  REQUIRE(cellNames[c3] == "c3");
+  REQUIRE(cellWidths[99999] == 0.0);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(cellWidths.data()) % 64 == 0);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(cellNames.data()) % 64 == 0);
+
+  //observers are notified in registration order
+  struct OrderObserver : public Observer
+  {
+    std::vector<int> & order;
+    int index;
+    OrderObserver(std::vector<int> & order, int index) : order(order), index(index) {}
+    void create() override { order.push_back(index); }
+    void reserve(unsigned size) override {}
+    unsigned size() override { return 0; }
+  };
+  std::vector<int> order;
+  behavioral::StandardCells orderedCells;
+  std::vector<std::unique_ptr<OrderObserver>> orderObservers;
+  for(int index = 0; index < 16; ++index)
+  {
+    orderObservers.emplace_back(new OrderObserver(order, index));
+    orderedCells.attach(orderObservers.back().get());
+  }
+  orderedCells.detach(orderObservers[3].get());
+  orderedCells.createN(1);
+  std::vector<int> expectedOrder(16);
+  std::iota(expectedOrder.begin(), expectedOrder.end(), 0);
+  expectedOrder.erase(expectedOrder.begin() + 3);
+  REQUIRE(order == expectedOrder);
+  //observers without compaction support (the default) keep working, but the cells are not compacted under them
+  orderedCells.erase(0);
+  REQUIRE_THROWS_AS(orderedCells.compact(), std::logic_error &);
+  REQUIRE(orderedCells.numErased() == 1);
+  REQUIRE_THROWS_AS(orderObservers[0]->compact({}), std::logic_error &);
+
+  std::cout << "--Erase and compact" << std::endl;
+  for(CellId id = first; id < stdCells.size(); ++id)
+  {
+    cellNames[id] = "c" + std::to_string(id);
+    cellWidths[id - first] = id;
+  }
+  for(CellId id = 1; id < stdCells.size(); id += 3)
+  {
+    stdCells.erase(id);
+  }
+  REQUIRE_THROWS_AS(stdCells.erase(1), std::out_of_range &);
+  REQUIRE_THROWS_AS(stdCells.erase(stdCells.size()), std::out_of_range &);
+  REQUIRE_FALSE(stdCells.alive(4));
+  REQUIRE(stdCells.alive(5));
+  REQUIRE(stdCells.numErased() == 33335);
+
+  stdCells.detach(&cellWidths);
+  stdCells.attach(&cellAreas);
+  const std::vector<CellId> & remap = stdCells.compact();
+  REQUIRE(remap.size() == 100005);
+  REQUIRE(stdCells.size() == 100005 - 33335);
+  REQUIRE(stdCells.numErased() == 0);
+  REQUIRE(cellNames.size() == stdCells.size());
+  REQUIRE(cellWidths.size() == 100000);
+  for(CellId id = 0; id < remap.size(); ++id)
+  {
+    if(id % 3 == 1)
+    {
+      REQUIRE(remap[id] == InvalidCellId);
+    }
+    else
+    {
+      REQUIRE(remap[id] == id - (id + 1) / 3);
+      if(id >= first)
+        REQUIRE(cellNames[remap[id]] == "c" + std::to_string(id));
+    }
+  }
+  REQUIRE(cellNames[remap[c3]] == "c3");
+  //late attached observers only keep their remaining elements
+  REQUIRE(cellAreas.size() == 2);
+  REQUIRE(cellAreas[remap[c3]] == 2.0);
+  const unsigned compactedSize = stdCells.size();
+  REQUIRE(stdCells.createN(1) == compactedSize);
+  REQUIRE(&stdCells.remap() == &remap);
+
+  std::cout << "--Concurrent creation" << std::endl;
+  behavioral::StandardCells parallelCells;
+  ConcurrentCellProperties<int> creationIndices;
+  ConcurrentCellProperties<double> parallelAreas;
+  parallelCells.attach(&creationIndices);
+  parallelCells.attach(&parallelAreas);
+  parallelCells.createN(10);
+  parallelCells.attach(&cellWidths);
+  REQUIRE_THROWS_AS(parallelCells.beginConcurrentCreation(), std::logic_error &);
+  parallelCells.detach(&cellWidths);
+
+  parallelCells.beginConcurrentCreation(100);
+  REQUIRE_THROWS_AS(parallelCells.create(), std::logic_error &);
+  const int numCreated = 50000;
+#ifdef _OPENMP
+  #pragma omp parallel
+#endif
+  {
+    CellIdRange range;
+#ifdef _OPENMP
+    #pragma omp for schedule(dynamic, 37)
+#endif
+    for(int i = 0; i < numCreated; ++i)
+    {
+      CellId id = parallelCells.createConcurrent(range);
+      creationIndices[id] = i + 1;
+      parallelAreas[id] = 0.5 * i;
+    }
+    parallelCells.release(range);
+  }
+  parallelCells.endConcurrentCreation();
+  REQUIRE(creationIndices.size() == parallelCells.size());
+  REQUIRE(parallelAreas.size() == parallelCells.size());
+  REQUIRE(parallelCells.size() - parallelCells.numErased() == 10 + numCreated);
+
+  parallelCells.compact();
+  REQUIRE(parallelCells.size() == 10 + numCreated);
+  REQUIRE(creationIndices.size() == parallelCells.size());
+  std::vector<int> created(numCreated, 0);
+  for(CellId id = 10; id < parallelCells.size(); ++id)
+  {
+    REQUIRE(creationIndices[id] > 0);
+    REQUIRE(parallelAreas[id] == 0.5 * (creationIndices[id] - 1));
+    ++created[creationIndices[id] - 1];
+  }
+  REQUIRE(std::count(created.begin(), created.end(), 1) == numCreated);
+  REQUIRE(parallelCells.create() == CellId(10 + numCreated));
+  REQUIRE(creationIndices[10 + numCreated] == 0);
+
+  std::cout << "--Change tracking" << std::endl;
+  behavioral::StandardCells trackedCells;
+  TrackedCellProperties<common::Location> trackedLocations;
+  auto timing = trackedLocations.addConsumer();
+  trackedCells.attach(&trackedLocations);
+  trackedCells.createN(1000);
+  auto legalization = trackedLocations.addConsumer();
+  std::vector<CellId> dirtyCells;
+  trackedLocations.drain(timing, dirtyCells);
+  REQUIRE(dirtyCells.size() == 1000);
+  REQUIRE(trackedLocations.numDirty(legalization) == 0);
+
+  trackedLocations.set(7, Location{1, 2});
+  trackedLocations.modify(300).first = 5;
+  trackedLocations.set(7, Location{3, 4});
+  trackedLocations.drain(timing, dirtyCells);
+  REQUIRE(dirtyCells == std::vector<CellId>({7, 300}));
+  REQUIRE(trackedLocations.numDirty(timing) == 0);
+  REQUIRE(trackedLocations[7] == Location(3, 4));
+  REQUIRE(trackedLocations[300] == Location(5, 0));
+
+  //each consumer has its own epoch
+  trackedLocations.set(7, Location{5, 6});
+  trackedLocations.drain(timing, dirtyCells);
+  REQUIRE(dirtyCells == std::vector<CellId>({7}));
+  trackedLocations.drain(legalization, dirtyCells);
+  REQUIRE(dirtyCells == std::vector<CellId>({7, 300}));
+
+  //created cells are dirty and compaction renumbers the dirty cells
+  trackedLocations.set(600, Location{9, 9});
+  trackedLocations.set(5, Location{8, 8});
+  CellId newCell = trackedCells.create();
+  trackedCells.erase(5);
+  trackedCells.erase(100);
+  const std::vector<CellId> & trackedRemap = trackedCells.compact();
+  trackedLocations.drain(legalization, dirtyCells);
+  REQUIRE(dirtyCells == std::vector<CellId>({trackedRemap[600], trackedRemap[newCell]}));
+  REQUIRE(trackedLocations[trackedRemap[600]] == Location(9, 9));
+  trackedLocations.set(trackedRemap[newCell], Location{1, 1});
+  trackedLocations.drain(legalization, dirtyCells);
+  REQUIRE(dirtyCells == std::vector<CellId>({trackedRemap[newCell]}));
 }
 
 
@@ -299,6 +1351,340 @@ TEST_CASE("Bridge", "[structural][bridge]")
     LateEarlyTimingAnalysisInterface earlyLateSta( std::make_unique<EffectiveCapD2MTimingAnalysisImplementation>(timingPoints) );
     earlyLateSta.run();
   }
+
+  std::vector<TimingPoint> graphTimingPoints{{0, 0}, {1, 1}, {2, 2}, {3, 3}, {4, 4}};
+  std::vector<TimingArc> timingArcs{{0, 2, 1.0}, {1, 2, 2.0}, {2, 3, 1.5}, {2, 4, 0.5}};
+
+  {
+    std::cout << "---Topological sort of the timing graph" << std::endl;
+    TimingGraph graph(graphTimingPoints.size(), timingArcs);
+    REQUIRE( graph.topologicalSort().numLevels() == 3 );
+
+    TimingGraph loop(2, {{0, 1, 1.0}, {1, 0, 1.0}});
+    REQUIRE_THROWS( loop.topologicalSort() );
+  }
+
+  {
+    std::cout << "---Late/Early slacks of the timing graph" << std::endl;
+    LateEarlyTimingAnalysisInterface earlyLateSta( std::make_unique<LumpedCapElmoreDelayTimingAnalysisImplementation>(graphTimingPoints, timingArcs, 5.0) );
+    earlyLateSta.run();
+    REQUIRE( earlyLateSta.lateSlack(graphTimingPoints[0]) == Approx(2.5) );
+    REQUIRE( earlyLateSta.lateSlack(graphTimingPoints[1]) == Approx(1.5) );
+    REQUIRE( earlyLateSta.lateSlack(graphTimingPoints[3]) == Approx(1.5) );
+    REQUIRE( earlyLateSta.lateSlack(graphTimingPoints[4]) == Approx(2.5) );
+    REQUIRE( earlyLateSta.earlySlack(graphTimingPoints[1]) == Approx(2.5) );
+    REQUIRE( earlyLateSta.earlySlack(graphTimingPoints[2]) == Approx(1.5) );
+    REQUIRE( earlyLateSta.earlySlack(graphTimingPoints[4]) == Approx(1.5) );
+
+    std::cout << "---Incremental STA after changing the delay of 2 -> 3" << std::endl;
+    earlyLateSta.setArcDelay(graphTimingPoints[2], graphTimingPoints[3], 3.0);
+    earlyLateSta.runIncremental();
+
+    timingArcs[2].delay = 3.0;
+    LateEarlyTimingAnalysisInterface fullSta( std::make_unique<LumpedCapElmoreDelayTimingAnalysisImplementation>(graphTimingPoints, timingArcs, 5.0) );
+    fullSta.run();
+    for(auto & tp : graphTimingPoints)
+    {
+      REQUIRE( earlyLateSta.lateSlack(tp) == Approx(fullSta.lateSlack(tp)) );
+      REQUIRE( earlyLateSta.earlySlack(tp) == Approx(fullSta.earlySlack(tp)) );
+    }
+    REQUIRE( earlyLateSta.lateSlack(graphTimingPoints[1]) == Approx(0.0) );
+
+    std::cout << "---Slack cache" << std::endl;
+    earlyLateSta.resetSlackCacheStatistics();
+    earlyLateSta.lateSlack(graphTimingPoints[1]);
+    REQUIRE( earlyLateSta.slackCacheStatistics().hits == 1 );
+
+    earlyLateSta.setStaleSlackPolicy(StaleSlackPolicy::REPORT_STALE);
+    earlyLateSta.setArcDelay(graphTimingPoints[1], graphTimingPoints[2], 3.0);
+    REQUIRE( earlyLateSta.slacksStale() );
+    REQUIRE( earlyLateSta.lateSlack(graphTimingPoints[1]) == Approx(0.0) );
+    REQUIRE( earlyLateSta.slackCacheStatistics().staleQueries == 1 );
+
+    earlyLateSta.setStaleSlackPolicy(StaleSlackPolicy::RECOMPUTE);
+    REQUIRE( earlyLateSta.lateSlack(graphTimingPoints[1]) == Approx(-1.0) );
+    REQUIRE( !earlyLateSta.slacksStale() );
+    REQUIRE( earlyLateSta.slackCacheStatistics().recomputes == 1 );
+    REQUIRE( earlyLateSta.slackCacheStatistics().hitRate() == Approx(0.5) );
+
+    earlyLateSta.setArcDelay(graphTimingPoints[1], graphTimingPoints[2], 2.0);
+    REQUIRE( earlyLateSta.lateSlack(graphTimingPoints[1]) == Approx(0.0) );
+
+    std::cout << "---Worst paths" << std::endl;
+    auto paths = earlyLateSta.reportWorstPaths(3);
+    REQUIRE( paths.size() == 3 );
+    REQUIRE( paths[0].slack == Approx(0.0) );
+    REQUIRE( paths[0].timingPoints == std::vector<unsigned>({1, 2, 3}) );
+    REQUIRE( paths[1].slack == Approx(1.0) );
+    REQUIRE( paths[1].timingPoints == std::vector<unsigned>({0, 2, 3}) );
+    REQUIRE( paths[2].slack == Approx(2.5) );
+    REQUIRE( earlyLateSta.reportWorstPaths(10).size() == 4 );
+
+    std::cout << "---Timing snapshot" << std::endl;
+    //Unique file under the temp directory, removed even when a REQUIRE below fails
+    struct RemoveOnExit
+    {
+      std::string path;
+      ~RemoveOnExit() { std::remove(path.c_str()); }
+    };
+    const char * tmpDir = std::getenv("TMPDIR");
+    RemoveOnExit snapshotFile{std::string(tmpDir ? tmpDir : "/tmp") + "/bridge_timing_snapshot_" + std::to_string(::getpid()) + ".bin"};
+    earlyLateSta.writeSnapshot(snapshotFile.path);
+    {
+      TimingSnapshot snapshot(snapshotFile.path);
+      REQUIRE( snapshot.numTimingPoints() == graphTimingPoints.size() );
+      REQUIRE( snapshot.numArcs() == timingArcs.size() );
+      REQUIRE( snapshot.numLevels() == 3 );
+      REQUIRE( snapshot.topologicalSortedTPs()[snapshot.levelOffsets()[2]].id == 3 );
+      for(auto & tp : graphTimingPoints)
+      {
+        REQUIRE( snapshot.lateSlack(tp) == earlyLateSta.lateSlack(tp) );
+        REQUIRE( snapshot.earlySlack(tp) == earlyLateSta.earlySlack(tp) );
+      }
+      REQUIRE( snapshot.timed() );
+      REQUIRE( snapshot.earlyScenario() );
+      REQUIRE( snapshot.clockPeriod() == 5.0 );
+
+      std::cout << "---Incremental STA restored from the timing snapshot" << std::endl;
+      LateEarlyTimingAnalysisInterface restoredSta( std::make_unique<LumpedCapElmoreDelayTimingAnalysisImplementation>(snapshot) );
+      REQUIRE( !restoredSta.slacksStale() );
+      for(auto & tp : graphTimingPoints)
+      {
+        REQUIRE( restoredSta.lateSlack(tp) == earlyLateSta.lateSlack(tp) );
+        REQUIRE( restoredSta.earlySlack(tp) == earlyLateSta.earlySlack(tp) );
+      }
+      REQUIRE( restoredSta.slackCacheStatistics().recomputes == 0 );
+
+      restoredSta.setArcDelay(graphTimingPoints[0], graphTimingPoints[2], 4.0);
+      restoredSta.runIncremental();
+
+      auto restoredArcs = timingArcs;
+      restoredArcs[0].delay = 4.0;
+      LateEarlyTimingAnalysisInterface fullSta( std::make_unique<LumpedCapElmoreDelayTimingAnalysisImplementation>(graphTimingPoints, restoredArcs, 5.0) );
+      fullSta.run();
+      for(auto & tp : graphTimingPoints)
+      {
+        REQUIRE( restoredSta.lateSlack(tp) == Approx(fullSta.lateSlack(tp)) );
+        REQUIRE( restoredSta.earlySlack(tp) == Approx(fullSta.earlySlack(tp)) );
+      }
+      REQUIRE( restoredSta.worstNegativeLateSlack() == Approx(fullSta.worstNegativeLateSlack()) );
+      REQUIRE( restoredSta.lateSlack(graphTimingPoints[0]) == Approx(-2.0) );
+    }
+    std::remove(snapshotFile.path.c_str());
+    REQUIRE_THROWS( TimingSnapshot(snapshotFile.path) );
+  }
+
+  {
+    std::cout << "---Worst paths and bulk queries after pending arc delay changes" << std::endl;
+    std::vector<TimingPoint> tps{{0, 0}, {1, 1}, {2, 2}, {3, 3}};
+    LateEarlyTimingAnalysisInterface sta( std::make_unique<LumpedCapElmoreDelayTimingAnalysisImplementation>(tps, std::vector<TimingArc>{{0, 1, 1.0}, {1, 2, 1.0}, {0, 3, 2.5}}, 5.0) );
+    sta.run();
+    REQUIRE( sta.reportWorstPaths(1)[0].timingPoints.back() == 3 );
+
+    sta.setStaleSlackPolicy(StaleSlackPolicy::REPORT_STALE);
+    sta.setArcDelay(tps[1], tps[2], 9.0);
+    REQUIRE( sta.worstNegativeLateSlack() == Approx(0.0) );
+    REQUIRE( sta.reportWorstPaths(1)[0].timingPoints.back() == 3 );
+    REQUIRE( sta.slackCacheStatistics().staleQueries == 2 );
+    REQUIRE( sta.slacksStale() );
+
+    sta.setStaleSlackPolicy(StaleSlackPolicy::RECOMPUTE);
+    auto paths = sta.reportWorstPaths(1);
+    REQUIRE( !sta.slacksStale() );
+    REQUIRE( paths[0].timingPoints == std::vector<unsigned>({0, 1, 2}) );
+    REQUIRE( paths[0].slack == Approx(-5.0) );
+
+    sta.setArcDelay(tps[1], tps[2], 1.0);
+    REQUIRE( sta.worstNegativeLateSlack() == Approx(0.0) );
+    sta.setArcDelay(tps[0], tps[3], 6.0);
+    REQUIRE( sta.totalNegativeLateSlack() == Approx(-1.0) );
+    sta.setArcDelay(tps[0], tps[3], 7.0);
+    REQUIRE( sta.numLateViolations() == 1 );
+    sta.setArcDelay(tps[0], tps[1], 4.0);
+    REQUIRE( sta.lateSlackHistogram(-10.0, 10.0, 2) == std::vector<std::size_t>({1, 1}) );
+  }
+
+  {
+    std::cout << "---Parallel propagation matches the serial one" << std::endl;
+    //levels wider than the parallel threshold of the propagation
+    const unsigned numLevels = 6, width = 3000;
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<double> delay(0.1, 3.0);
+    std::vector<TimingPoint> wideTimingPoints;
+    std::vector<TimingArc> wideArcs;
+    for(unsigned node = 0; node < numLevels * width; ++node)
+    {
+      wideTimingPoints.push_back({node, node});
+      for(unsigned fanin = 0; node >= width && fanin < 3; ++fanin)
+      {
+        wideArcs.push_back({node - width - node % width + unsigned(generator() % width), node, delay(generator)});
+      }
+    }
+
+    auto slacks = [&](int numThreads)
+    {
+#ifdef _OPENMP
+      omp_set_num_threads(numThreads);
+#endif
+      LateEarlyTimingAnalysisInterface sta( std::make_unique<EffectiveCapD2MTimingAnalysisImplementation>(wideTimingPoints, wideArcs, 10.0) );
+      sta.run();
+      std::vector<double> values;
+      for(auto & tp : wideTimingPoints)
+      {
+        values.push_back(sta.lateSlack(tp));
+        values.push_back(sta.earlySlack(tp));
+      }
+      return values;
+    };
+#ifdef _OPENMP
+    const int maxThreads = omp_get_max_threads();
+#endif
+    auto serial = slacks(1);
+    REQUIRE( slacks(8) == serial );
+    REQUIRE( slacks(3) == serial );
+#ifdef _OPENMP
+    omp_set_num_threads(maxThreads);
+#endif
+  }
+
+  {
+    std::cout << "---Bulk slack queries" << std::endl;
+    LateEarlyTimingAnalysisInterface earlyLateSta( std::make_unique<EffectiveCapElmoreDelayTimingAnalysisImplementation>(graphTimingPoints, timingArcs, 4.0) );
+    earlyLateSta.run();
+    REQUIRE( earlyLateSta.worstNegativeLateSlack() == Approx(-1.0) );
+    REQUIRE( earlyLateSta.totalNegativeLateSlack() == Approx(-1.0) );
+    REQUIRE( earlyLateSta.numLateViolations() == 1 );
+    REQUIRE( earlyLateSta.lateSlackHistogram(-2.0, 2.0, 4) == std::vector<std::size_t>({0, 1, 0, 1}) );
+    REQUIRE( earlyLateSta.worstNegativeEarlySlack() == Approx(0.0) );
+    REQUIRE( earlyLateSta.numEarlyViolations() == 0 );
+  }
+
+  {
+    std::cout << "---Multi-corner STA" << std::endl;
+    std::vector<TimingCorner> corners{ {"typical", 1.0, 4.0}, {"slow", 1.5, 4.0}, {"fast", 0.5, 2.0} };
+    MultiCornerTimingAnalysisInterface multiCornerSta( std::make_unique<EffectiveCapD2MTimingAnalysisImplementation>(graphTimingPoints, timingArcs), corners );
+    multiCornerSta.run();
+
+    LateEarlyTimingAnalysisInterface typicalSta( std::make_unique<EffectiveCapD2MTimingAnalysisImplementation>(graphTimingPoints, timingArcs, 4.0) );
+    typicalSta.run();
+    for(auto & tp : graphTimingPoints)
+    {
+      REQUIRE( multiCornerSta.lateSlack(tp, 0) == Approx(typicalSta.lateSlack(tp)) );
+      REQUIRE( multiCornerSta.earlySlack(tp, 0) == Approx(typicalSta.earlySlack(tp)) );
+    }
+    REQUIRE( multiCornerSta.lateSlack(graphTimingPoints[3], 1) == Approx(-3.5) );
+    REQUIRE( multiCornerSta.lateSlack(graphTimingPoints[3], 2) == Approx(-0.5) );
+    REQUIRE( multiCornerSta.earlySlack(graphTimingPoints[4], 2) == Approx(0.75) );
+    REQUIRE_THROWS( multiCornerSta.lateSlack(graphTimingPoints[3], 3) );
+    REQUIRE( multiCornerSta.worstNegativeLateSlack(1) == Approx(-3.5) );
+    REQUIRE( multiCornerSta.numLateViolations(0) == typicalSta.numLateViolations() );
+    REQUIRE( multiCornerSta.totalNegativeEarlySlack(2) == Approx(0.0) );
+    REQUIRE_THROWS_AS( multiCornerSta.worstNegativeLateSlack(3), std::out_of_range & );
+
+    std::cout << "---Multi-corner STA after a timing graph change" << std::endl;
+    REQUIRE( !multiCornerSta.slacksStale() );
+    multiCornerSta.resetSlackCacheStatistics();
+    multiCornerSta.setArcDelay(graphTimingPoints[0], graphTimingPoints[2], 4.0);
+    REQUIRE( multiCornerSta.slacksStale() );
+
+    auto changedArcs = timingArcs;
+    changedArcs[0].delay = 4.0;
+    MultiCornerTimingAnalysisInterface changedSta( std::make_unique<EffectiveCapD2MTimingAnalysisImplementation>(graphTimingPoints, changedArcs), corners );
+    changedSta.run();
+    for(auto & tp : graphTimingPoints)
+    {
+      for(std::size_t corner = 0; corner < corners.size(); ++corner)
+      {
+        REQUIRE( multiCornerSta.lateSlack(tp, corner) == Approx(changedSta.lateSlack(tp, corner)) );
+        REQUIRE( multiCornerSta.earlySlack(tp, corner) == Approx(changedSta.earlySlack(tp, corner)) );
+      }
+    }
+    REQUIRE( !multiCornerSta.slacksStale() );
+    REQUIRE( multiCornerSta.slackCacheStatistics().recomputes == 1 );
+    REQUIRE( multiCornerSta.lateSlack(graphTimingPoints[3], 1) == Approx(changedSta.lateSlack(graphTimingPoints[3], 1)) );
+    REQUIRE( multiCornerSta.slackCacheStatistics().hits == 1 );
+    for(std::size_t corner = 0; corner < corners.size(); ++corner)
+    {
+      REQUIRE( multiCornerSta.worstNegativeLateSlack(corner) == Approx(changedSta.worstNegativeLateSlack(corner)) );
+      REQUIRE( multiCornerSta.worstNegativeEarlySlack(corner) == Approx(changedSta.worstNegativeEarlySlack(corner)) );
+    }
+
+    multiCornerSta.setStaleSlackPolicy(StaleSlackPolicy::REPORT_STALE);
+    double slowSlack = multiCornerSta.lateSlack(graphTimingPoints[3], 1);
+    multiCornerSta.setArcDelay(graphTimingPoints[0], graphTimingPoints[2], 1.0);
+    REQUIRE( multiCornerSta.lateSlack(graphTimingPoints[3], 1) == slowSlack );
+    REQUIRE( multiCornerSta.slackCacheStatistics().staleQueries == 1 );
+    REQUIRE( multiCornerSta.slackCacheStatistics().recomputes == 1 );
+    multiCornerSta.runIncremental();
+    REQUIRE( !multiCornerSta.slacksStale() );
+  }
+
+  {
+    std::cout << "---RC tree delays against a reference implementation" << std::endl;
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> value(0.1, 2.0);
+    RCTreeArena parasitics;
+    for(unsigned tree = 0; tree < 20; ++tree)
+    {
+      parasitics.addTree(value(generator), value(generator));
+      for(unsigned node = 1; node < 2 + tree; ++node)
+      {
+        parasitics.addNode(generator() % node, value(generator), value(generator));
+      }
+    }
+
+    std::vector<double> elmoreDelays, d2mDelays;
+    computeNetDelays<LoadModel::LUMPED_CAPACITANCE, WireDelayModel::ELMORE>(parasitics, elmoreDelays);
+    computeNetDelays<LoadModel::LUMPED_CAPACITANCE, WireDelayModel::D2M>(parasitics, d2mDelays);
+
+    for(unsigned tree = 0; tree < parasitics.numTrees(); ++tree)
+    {
+      auto size = parasitics.treeSize(tree);
+      auto parents = parasitics.parents(tree);
+      auto resistances = parasitics.resistances(tree);
+      auto capacitances = parasitics.capacitances(tree);
+      //resistance shared by the paths from the root to i and to k
+      auto sharedResistance = [&](unsigned i, unsigned k)
+      {
+        std::vector<bool> onPath(size, false);
+        for(; i != 0; i = parents[i]) onPath[i] = true;
+        double resistance = 0.0;
+        for(; k != 0; k = parents[k]) resistance += onPath[k] ? resistances[k] : 0.0;
+        return resistance;
+      };
+
+      double load = std::accumulate(capacitances, capacitances + size, 0.0);
+      double driverDelay = parasitics.driverResistance(tree) * load;
+      std::vector<double> m1(size, 0.0), m2(size, 0.0);
+      for(unsigned i = 0; i < size; ++i)
+        for(unsigned k = 0; k < size; ++k)
+          m1[i] += capacitances[k] * sharedResistance(i, k);
+      for(unsigned i = 0; i < size; ++i)
+        for(unsigned k = 0; k < size; ++k)
+          m2[i] += capacitances[k] * m1[k] * sharedResistance(i, k);
+
+      for(unsigned i = 1; i < size; ++i)
+      {
+        REQUIRE( elmoreDelays[parasitics.treeBegin(tree) + i] == Approx(driverDelay + m1[i]) );
+        REQUIRE( d2mDelays[parasitics.treeBegin(tree) + i] == Approx(driverDelay + std::log(2.0) * m1[i] * m1[i] / std::sqrt(m2[i])) );
+      }
+    }
+  }
+
+  {
+    std::cout << "---Net delays annotated from the parasitics" << std::endl;
+    RCTreeArena parasitics;
+    parasitics.addTree(1.0, 0.0);
+    parasitics.addNode(0, 2.0, 3.0);
+
+    std::vector<TimingPoint> netTimingPoints{{0, 0}, {1, 1}};
+    TimingAnalysisInterface lateSta( std::make_unique<LumpedCapElmoreDelayTimingAnalysisImplementation>(netTimingPoints, std::vector<TimingArc>{{0, 1, 0.0}}, 10.0) );
+    lateSta.run();
+    REQUIRE( lateSta.lateSlack(netTimingPoints[1]) == Approx(10.0) );
+    lateSta.annotateParasitics(parasitics, {{0, 1, 0, 1}});
+    lateSta.runIncremental();
+    REQUIRE( lateSta.lateSlack(netTimingPoints[1]) == Approx(1.0) );
+  }
 }
 
 TEST_CASE("Composite", "[structural][composite]") 